@@ -24,7 +24,6 @@
  * USAGE:
  * CONSTRAINTS:
  * ToDo:
- *   -Random Number Variable seed and run values are not changing test results
  */
 
 #include <sstream>
@@ -53,6 +52,18 @@
 #include "ns3/olsr-helper.h"
 #include "ns3/rng-seed-manager.h"
 #include "ns3/random-variable-stream.h"
+#include "sampled-animation.h"
+#include "pcap-capture.h"
+#include "link-timeline.h"
+#include "event-scheduler.h"
+#include "packet-metadata.h"
+#include "memory-report.h"
+#include "compact-stack.h"
+#include "run-results.h"
+#include "run-budget.h"
+#include "traffic-replay.h"
+#include "path-tracer.h"
+#include "radio-energy.h"
 
 NS_LOG_COMPONENT_DEFINE ("SIFTCompare");
 
@@ -97,6 +108,16 @@ private:
   uint32_t SeedValue;
   int initGridSpacing;              // distance between nodes in grid topology
   bool pcap;             // PCAP enable/disable
+  PcapCapture capture;   // pcap filters, see pcap-capture.h
+  bool asciiTrace;       // wifi ascii trace to <protocol>.tr
+  PacketMetadataLevel metadata;   // packet metadata/tags, see packet-metadata.h
+  MemoryReport memory;            // per node/layer memory, see memory-report.h
+  std::string stack;              // internet stack profile, see compact-stack.h
+  RunResults results;             // Report () values for sweeps, see run-results.h
+  RunBudget budget;               // wall/event/RSS limits, see run-budget.h
+  TrafficReplay replay;           // trace-driven traffic, see traffic-replay.h
+  PathTracer paths;               // per-flow hop counts, see path-tracer.h
+  RadioEnergy energy;             // battery/radio energy, see radio-energy.h
   double xmax;                 // x Length of Mobility area
   double ymax;                 // y Width of Mobility area
   double zmax;                 // z Height of Mobility Area                
@@ -107,13 +128,23 @@ private:
   NodeContainer mobileNodes;
   NetDeviceContainer allDevices;
   Ipv4InterfaceContainer allInterfaces;
+  ApplicationContainer sinks;
+  uint64_t rxPackets;                             // counted by SinkRx, sizes vary with trafficTrace
   uint32_t periodicUpdateInterval;                // DSDV Parameter
   uint32_t settlingTime;                          // DSDV Parameter
+  std::string mobilityTrace;                      // ns-2 trace replayed instead of SelectMobilityModel
+  bool linkTimeline;                              // answer RangePropagation from the precomputed timeline
+  std::string linkStats;                          // prefix of the link/partition CSV export
+  LinkTimeline timeline;
+  std::string scheduler;                          // event scheduler, see event-scheduler.h
+  std::string schedulerTrace;                     // record scheduler operations for scheduler-bench
+  SampledAnimation anim;                          // NetAnim output, see sampled-animation.h
 
   void CreateNodes ();
   void CreateDevices ();
   void InstallInternetStack ();
   void InstallApplications ();
+  void SinkRx (Ptr<const Packet> packet, const Address &from);
 };
 
 int main (int argc, char **argv)
@@ -130,6 +161,7 @@ int main (int argc, char **argv)
 }
 
 SIFTCompare::SIFTCompare ()   // INITIALIZE ALL VARIABLES
+  : anim ("none", "SiftAnim.xml")
 {
   nNodes = 30;
   nFlows = 2;
@@ -155,9 +187,14 @@ SIFTCompare::SIFTCompare ()   // INITIALIZE ALL VARIABLES
   phyMode = "DsssRate11Mbps";
   SeedValue= 12345;
   SeedRun = 54321;
+  rxPackets = 0;
   periodicUpdateInterval = 15;   // DSDV Parameter
   settlingTime = 6;              // DSDV Parameter
   pcap = false;
+  asciiTrace = true;
+  stack = "full";
+  linkTimeline = false;
+  scheduler = "map";
 }
 
 bool
@@ -175,7 +212,7 @@ SIFTCompare::Configure (int argc, char **argv)
   Ptr<ConstantRandomVariable> CRV = CreateObject<ConstantRandomVariable> ();
   CommandLine cmd;
 
-  cmd.AddValue ("SeedValue", "Specify a new seed for the run.  Default:1", SeedValue);
+  cmd.AddValue ("SeedValue", "Specify a new seed for the run.  Default:12345", SeedValue);
   cmd.AddValue ("SeedRun", "Run index (for setting repeatable seeds)", SeedRun);
   cmd.AddValue ("nNodes", "Number of wifi nodes", nNodes);
   cmd.AddValue ("nFlows", "Number of SINK traffic nodes", nFlows);
@@ -191,7 +228,58 @@ SIFTCompare::Configure (int argc, char **argv)
   cmd.AddValue ("yDelta", "Specify starting position y spacing, Default:200", yDelta);
   cmd.AddValue ("zDelta", "Specify starting position z spacing, Default:200", zDelta);
   cmd.AddValue ("rate", "CBR traffic rate(in kbps), Default:8", rate);
+  anim.AddCommandLine (cmd);
+  cmd.AddValue ("mobilityTrace", "Replay an ns-2 mobility trace instead of the mobility model", mobilityTrace);
+  cmd.AddValue ("linkTimeline", "Use the link timeline of mobilityTrace instead of per-frame distances, Default:false", linkTimeline);
+  cmd.AddValue ("linkStats", "Write link durations and partitions of mobilityTrace to <prefix>-*.csv", linkStats);
+  cmd.AddValue ("scheduler", "Event scheduler: map, heap, list, calendar or quadheap, Default:map", scheduler);
+  cmd.AddValue ("schedulerTrace", "Record scheduler operations to this file for scheduler-bench", schedulerTrace);
+  cmd.AddValue ("pcap", "Enable pcap capture, Default:false", pcap);
+  capture.AddCommandLine (cmd);
+  cmd.AddValue ("asciiTrace", "Write the wifi ascii trace, Default:true", asciiTrace);
+  metadata.AddCommandLine (cmd);
+  memory.AddCommandLine (cmd);
+  cmd.AddValue ("stack", "Internet stack: full or compact (IPv4/UDP only), Default:full", stack);
+  results.AddCommandLine (cmd);
+  budget.AddCommandLine (cmd);
+  replay.AddCommandLine (cmd);
+  paths.AddCommandLine (cmd);
+  energy.AddCommandLine (cmd);
   cmd.Parse (argc, argv);
+  // After Parse, so that --SeedValue/--SeedRun and --totalTime take effect
+  RngSeedManager::SetSeed (SeedValue);
+  RngSeedManager::SetRun (SeedRun);
+  dataTime = totalTime - totalTime * .01;
+  if (linkTimeline && mobilityTrace.empty ())
+    {
+      std::cout << "linkTimeline needs a mobilityTrace\n";
+      return false;
+    }
+  if (stack != "full" && stack != "compact")
+    {
+      std::cout << "Unknown stack " << stack << "\n";
+      return false;
+    }
+  if (!metadata.Resolve (asciiTrace, false))
+    {
+      std::cout << "Unknown packetMetadata level\n";
+      return false;
+    }
+  if (!SelectScheduler (scheduler, schedulerTrace))
+    {
+      std::cout << "Unknown scheduler " << scheduler << "\n";
+      return false;
+    }
+  if (!budget.IsValid ())
+    {
+      std::cout << "budgetCheck must be a positive number of seconds\n";
+      return false;
+    }
+  if (!replay.Open ())
+    {
+      std::cout << "Cannot read traffic trace\n";
+      return false;
+    }
   std::cout << "nodePauseTime "<< nodePauseTime << " nFlows " << nFlows << " totalTime " << totalTime << " nodeMaxSpeed " << nodeMaxSpeed << "\n";
   return true;
 }
@@ -201,19 +289,75 @@ SIFTCompare::Run ()
 {  
   Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", UintegerValue (1)); // enable rts cts all the time.
   CreateNodes ();
+  if (!mobilityTrace.empty () && (linkTimeline || !linkStats.empty ()))
+    {
+      timeline.Build (mobilityTrace, nNodes, TxMaxRange, totalTime);
+      if (!linkStats.empty ())
+        {
+          timeline.WriteStats (linkStats);
+        }
+    }
   CreateDevices ();
   InstallInternetStack ();
   InstallApplications ();
+  for (uint32_t i = 0; i < sinks.GetN (); ++i)
+    {
+      sinks.Get (i)->TraceConnectWithoutContext ("Rx", MakeCallback (&SIFTCompare::SinkRx, this));
+    }
+  energy.Install (mobileNodes, allDevices, totalTime);
   std::cout << "Starting simulation for " << totalTime << " s ...\n";
   Simulator::Stop (Seconds (totalTime));
-  //AnimationInterface anim ("SiftAnim.xml");
+  anim.Install ();
+  metadata.StartCost ();
+  memory.Install ();
+  results.StartRun ();
+  budget.Install ();
+  paths.Install ();
   Simulator::Run ();
+  results.StopRun ();
+  metadata.StopCost ();
+  memory.Finish ();
+  energy.Finish ();
   Simulator::Destroy ();
+  anim.Close ();
 }
 
 void
-SIFTCompare::Report (std::ostream &)
+SIFTCompare::Report (std::ostream &os)
 {
+  if (timeline.IsBuilt ())
+    {
+      timeline.Report (os);
+    }
+  metadata.ReportCost (os);
+  memory.Report (os);
+
+  uint64_t rxBytes = 0;
+  for (uint32_t i = 0; i < sinks.GetN (); ++i)
+    {
+      rxBytes += DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx ();
+    }
+  os << "Delivered " << rxBytes << " bytes to " << sinks.GetN () << " sinks\n";
+  results.Add ("nNodes", nNodes);
+  results.Add ("totalTime", totalTime);
+  results.Add ("nFlows", nFlows);
+  results.Add ("packetSize", packetSize);
+  results.Add ("rate", rate);
+  results.Add ("nodeMaxSpeed", nodeMaxSpeed);
+  results.Add ("nodePauseTime", nodePauseTime);
+  results.Add ("TxMaxRange", TxMaxRange);
+  results.Add ("xmax", xmax);
+  results.Add ("ymax", ymax);
+  results.Add ("rxBytes", rxBytes);
+  // data flows from dataStartTime to dataTime, unless a budget stopped the run first
+  double dataSeconds = budget.GetEndTime (dataTime) - dataStartTime;
+  results.Add ("rxPackets", rxPackets);
+  results.Add ("throughputKbps", dataSeconds > 0 ? rxBytes * 8.0 / 1000 / dataSeconds : 0);
+  energy.Report (os, results, rxBytes);
+  paths.Report (os, results);
+  replay.Report (os, results);
+  budget.Report (os, results);
+  results.Write ();
 }
 
 void
@@ -227,6 +371,12 @@ SIFTCompare::CreateNodes ()
       os << "node-" << i;
       Names::Add (os.str (), mobileNodes.Get (i)); 
     }
+  if (!mobilityTrace.empty ())
+    {
+      Ns2MobilityHelper ns2 (mobilityTrace);
+      ns2.Install ();
+      return;
+    }
 
   MobilityHelper mobility;
   std::stringstream convert;
@@ -350,10 +500,23 @@ SIFTCompare::CreateDevices ()
   wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
   YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
 
-  YansWifiChannelHelper wifiChannel;
-  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
-  wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (TxMaxRange));
-  wifiPhy.SetChannel (wifiChannel.Create ());
+  if (linkTimeline)
+    {
+      // Same connectivity as RangePropagationLossModel, looked up instead of computed per frame
+      Ptr<LinkTimelineLossModel> lossModel = CreateObject<LinkTimelineLossModel> ();
+      lossModel->SetTimeline (&timeline);
+      Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+      channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      channel->SetPropagationLossModel (lossModel);
+      wifiPhy.SetChannel (channel);
+    }
+  else
+    {
+      YansWifiChannelHelper wifiChannel;
+      wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+      wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (TxMaxRange));
+      wifiPhy.SetChannel (wifiChannel.Create ());
+    }
   // Add a non-QoS upper mac, and disable rate control
   NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
   wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue (dataMode), "ControlMode",
@@ -365,52 +528,55 @@ SIFTCompare::CreateDevices ()
   //NS_LOG_INFO ("Configure Tracing.");
 
   AsciiTraceHelper ascii;
-  Ptr<OutputStreamWrapper> stream;
+  std::string traceFile;
   switch (RoutingProtocol)
     {
     case SIFT:
-      stream = ascii.CreateFileStream ("SIFT.tr");
+      traceFile = "SIFT.tr";
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("dggfpcap"));
+          capture.Install (wifiPhy, "dggfpcap", allDevices);
         }
       break;
     case AODV:
-      stream = ascii.CreateFileStream ("aodv.tr");
+      traceFile = "aodv.tr";
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("aodvpcap"));
+          capture.Install (wifiPhy, "aodvpcap", allDevices);
         }
       break;
     case DSDV:
-      stream = ascii.CreateFileStream ("dsdv.tr");
+      traceFile = "dsdv.tr";
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("dsdvpcap"));
+          capture.Install (wifiPhy, "dsdvpcap", allDevices);
         }
       break;
     case DSR:
-      stream = ascii.CreateFileStream ("dsrp.tr");
+      traceFile = "dsrp.tr";
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("dsrpcap"));
+          capture.Install (wifiPhy, "dsrpcap", allDevices);
         }
       break;
     case OLSR:
-      stream = ascii.CreateFileStream ("olsr.tr");
+      traceFile = "olsr.tr";
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("olsrpcap"));
+          capture.Install (wifiPhy, "olsrpcap", allDevices);
         }
       break;
     }
-  wifiPhy.EnableAsciiAll (stream);
+  if (metadata.AllowsAscii ())
+    {
+      wifiPhy.EnableAsciiAll (ascii.CreateFileStream (traceFile));
+    }
 }
 
 void
 SIFTCompare::InstallInternetStack ()
 {
-  InternetStackHelper internet;
+  CompactStackHelper internet (stack == "compact");
   // SIFT --------
   SiftMainHelper siftMain;
   SiftHelper sift;
@@ -462,15 +628,32 @@ SIFTCompare::InstallInternetStack ()
   allInterfaces = address.Assign (allDevices);
 }
 
+void
+SIFTCompare::SinkRx (Ptr<const Packet> packet, const Address &from)
+{
+  ++rxPackets;
+}
+
 void
 SIFTCompare::InstallApplications ()
 {
   uint16_t port = 9;
+  if (replay.IsEnabled ())
+    {
+      // a sink on every node, the trace decides who talks to whom
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      sinks = sink.Install (mobileNodes);
+      sinks.Start (Seconds (0.0));
+      sinks.Stop (Seconds (totalTime - 1));
+      replay.Install (mobileNodes, allInterfaces, Seconds (dataStartTime));
+      return;
+    }
   double randomStartTime = (1 / ppers) / nFlows;
   for (uint32_t i = 0; i < nFlows; ++i)
     {
       PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
       ApplicationContainer apps_sink = sink.Install (mobileNodes.Get (i));
+      sinks.Add (apps_sink);
       apps_sink.Start (Seconds (0.0));
       apps_sink.Stop (Seconds (totalTime - 1));
       OnOffHelper onoff1 ("ns3::UdpSocketFactory", Address (InetSocketAddress (allInterfaces.GetAddress (i), port)));
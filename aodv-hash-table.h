@@ -0,0 +1,283 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef AODV_HASH_TABLE_H
+#define AODV_HASH_TABLE_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/// One AODV route, stored inline in the hash table
+struct AodvRoute
+{
+  enum State
+  {
+    VALID, INVALID
+  };
+  uint32_t dst;       // IPv4 address, host order; 0 marks an empty slot
+  uint32_t nextHop;
+  uint32_t seqNo;
+  uint16_t hops;
+  uint16_t state;
+  int64_t expire;     // time steps
+};
+
+/*
+ * AODV routing table with the lifetime rules of ns-3's aodv::RoutingTable
+ * (an expired valid route turns invalid for deletePeriod, an expired
+ * invalid route is removed) but laid out for lookups on every forwarded
+ * packet and every RREQ:
+ *
+ *  - routes live inline in an open-addressed table keyed by destination,
+ *    linear probing, at most 70% full, deletion by backward shift so no
+ *    tombstones build up;
+ *  - expiry is a hashed timer wheel of `slots` buckets of `tick` time
+ *    steps.  Update () appends (dst, expire) to the bucket of the new
+ *    expiry time and never searches the old one: a record whose time no
+ *    longer matches the route is stale and dropped when its bucket comes
+ *    up.  Advance (now) visits only the buckets between the last call and
+ *    now, instead of scanning every route like RoutingTable::Purge ().
+ *
+ * Header only and independent of the ns-3 AODV module, which is outside
+ * this tree; aodv-table-bench.cc compares it with the map + full-scan
+ * layout of aodv::RoutingTable.
+ */
+class AodvHashTable
+{
+public:
+  AodvHashTable (int64_t tick, uint32_t slots, int64_t deletePeriod)
+    : m_tick (tick),
+      m_deletePeriod (deletePeriod),
+      m_size (0),
+      m_wheel (slots),
+      m_now (0)
+  {
+    AodvRoute empty = { 0, 0, 0, 0, 0, 0 };
+    m_table.assign (16, empty);
+  }
+
+  uint32_t Size () const
+  {
+    return m_size;
+  }
+
+  // Returns 0 when there is no route, valid or not, to dst.  Read only:
+  // changes must go through Update () so the expiry wheel sees them.
+  const AodvRoute *Lookup (uint32_t dst) const
+  {
+    return const_cast<AodvHashTable *> (this)->Find (dst);
+  }
+
+  // Adds or replaces the route to r.dst and schedules its expiry;
+  // dst 0 is the empty slot marker and cannot be stored
+  void Update (const AodvRoute &r)
+  {
+    if (r.dst == 0)
+      {
+        return;
+      }
+    if ((m_size + 1) * 10 > m_table.size () * 7)
+      {
+        Grow ();
+      }
+    AodvRoute *slot = Insert (r.dst);
+    *slot = r;
+    Schedule (r.dst, r.expire);
+  }
+
+  bool Erase (uint32_t dst)
+  {
+    if (dst == 0)
+      {
+        return false;
+      }
+    uint32_t mask = m_table.size () - 1;
+    uint32_t i = Hash (dst) & mask;
+    while (m_table[i].dst != dst)
+      {
+        if (m_table[i].dst == 0)
+          {
+            return false;
+          }
+        i = (i + 1) & mask;
+      }
+    // backward shift: pull later entries of the probe run into the hole
+    uint32_t hole = i;
+    for (uint32_t j = (i + 1) & mask; m_table[j].dst != 0; j = (j + 1) & mask)
+      {
+        uint32_t home = Hash (m_table[j].dst) & mask;
+        if (((j - home) & mask) >= ((j - hole) & mask))
+          {
+            m_table[hole] = m_table[j];
+            hole = j;
+          }
+      }
+    m_table[hole].dst = 0;
+    --m_size;
+    return true;
+  }
+
+  // Applies every expiry up to now
+  void Advance (int64_t now)
+  {
+    int64_t from = m_now / m_tick;
+    int64_t to = now / m_tick;
+    if (to - from >= int64_t (m_wheel.size ()))
+      {
+        from = to - m_wheel.size () + 1;
+      }
+    m_now = now;
+    for (int64_t t = from; t <= to; ++t)
+      {
+        std::vector<Record> &bucket = m_wheel[t % m_wheel.size ()];
+        uint32_t kept = 0;
+        for (uint32_t k = 0; k < bucket.size (); ++k)
+          {
+            Record rec = bucket[k];
+            if (rec.expire > now)
+              {
+                bucket[kept++] = rec;   // a later round of the wheel
+                continue;
+              }
+            AodvRoute *r = Find (rec.dst);
+            if (r == 0 || r->expire != rec.expire)
+              {
+                continue;               // stale: erased or refreshed since
+              }
+            if (r->state == AodvRoute::VALID)
+              {
+                r->state = AodvRoute::INVALID;
+                r->expire = now + m_deletePeriod;
+                Schedule (r->dst, r->expire);
+              }
+            else
+              {
+                Erase (rec.dst);
+              }
+          }
+        bucket.resize (kept);
+      }
+  }
+
+  // All routes, ordered by destination
+  std::vector<AodvRoute> GetRoutes () const
+  {
+    std::vector<AodvRoute> routes;
+    for (uint32_t i = 0; i < m_table.size (); ++i)
+      {
+        if (m_table[i].dst != 0)
+          {
+            routes.push_back (m_table[i]);
+          }
+      }
+    std::sort (routes.begin (), routes.end (), ByDst);
+    return routes;
+  }
+
+private:
+  struct Record
+  {
+    uint32_t dst;
+    int64_t expire;
+  };
+
+  static bool ByDst (const AodvRoute &a, const AodvRoute &b)
+  {
+    return a.dst < b.dst;
+  }
+
+  AodvRoute *Find (uint32_t dst)
+  {
+    if (dst == 0)
+      {
+        return 0;
+      }
+    uint32_t mask = m_table.size () - 1;
+    for (uint32_t i = Hash (dst) & mask; ; i = (i + 1) & mask)
+      {
+        if (m_table[i].dst == dst)
+          {
+            return &m_table[i];
+          }
+        if (m_table[i].dst == 0)
+          {
+            return 0;
+          }
+      }
+  }
+
+  static uint32_t Hash (uint32_t dst)
+  {
+    uint32_t h = dst * 2654435761u;
+    return h ^ (h >> 16);
+  }
+
+  AodvRoute *Insert (uint32_t dst)
+  {
+    uint32_t mask = m_table.size () - 1;
+    uint32_t i = Hash (dst) & mask;
+    while (m_table[i].dst != 0 && m_table[i].dst != dst)
+      {
+        i = (i + 1) & mask;
+      }
+    if (m_table[i].dst == 0)
+      {
+        ++m_size;
+      }
+    return &m_table[i];
+  }
+
+  void Grow ()
+  {
+    std::vector<AodvRoute> old;
+    old.swap (m_table);
+    AodvRoute empty = { 0, 0, 0, 0, 0, 0 };
+    m_table.assign (old.size () * 2, empty);
+    m_size = 0;
+    for (uint32_t i = 0; i < old.size (); ++i)
+      {
+        if (old[i].dst != 0)
+          {
+            *Insert (old[i].dst) = old[i];
+          }
+      }
+  }
+
+  void Schedule (uint32_t dst, int64_t expire)
+  {
+    int64_t t = expire / m_tick;
+    if (t < m_now / m_tick)
+      {
+        t = m_now / m_tick;
+      }
+    Record rec = { dst, expire };
+    m_wheel[t % m_wheel.size ()].push_back (rec);
+  }
+
+  int64_t m_tick;
+  int64_t m_deletePeriod;
+  uint32_t m_size;
+  std::vector<AodvRoute> m_table;
+  std::vector<std::vector<Record> > m_wheel;
+  int64_t m_now;
+};
+
+} // namespace ns3
+
+#endif /* AODV_HASH_TABLE_H */
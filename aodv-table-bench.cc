@@ -0,0 +1,267 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * AODV routing table benchmark: the ordered map + full-scan Purge () of
+ * ns-3's aodv::RoutingTable against AodvHashTable (aodv-hash-table.h),
+ * for each table size of --sizes.
+ *
+ *   insert  adding the routes to an empty table
+ *   lookup  --lookups lookups, 10% of them for unknown destinations
+ *   update  route refreshes during --seconds of simulated churn: every
+ *           10 ms step refreshes 0.5% of the routes, picked from the half
+ *           of the destinations still in use, with a new
+ *           ACTIVE_ROUTE_TIMEOUT lifetime (3 s plus up to 1 s).  Routes
+ *           to the other half turn invalid and are deleted 15 s later.
+ *   expiry  the expiry pass run after every step, Purge () for the map
+ *           and Advance () for the hash table, in microseconds per step
+ *
+ * Both tables see the same operations, so they must end with the same
+ * routes (destination, next hop, state and expiry); the last column says
+ * whether they do, and the exit status is 1 if any size differs.
+ *
+ * ./waf --run "aodv-table-bench --sizes=100,1000,10000,100000"
+ */
+
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "aodv-hash-table.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+static const int64_t MS = 1000000;             // time steps, ns resolution
+static const int64_t DELETE_PERIOD = 15000 * MS;  // 5 * ACTIVE_ROUTE_TIMEOUT
+
+/// The layout of aodv::RoutingTable: ordered map, expiry by full scan
+class MapRouteTable
+{
+public:
+  uint32_t Size () const
+  {
+    return m_routes.size ();
+  }
+
+  const AodvRoute *Lookup (uint32_t dst) const
+  {
+    std::map<uint32_t, AodvRoute>::const_iterator i = m_routes.find (dst);
+    return i == m_routes.end () ? 0 : &i->second;
+  }
+
+  std::vector<AodvRoute> GetRoutes () const
+  {
+    std::vector<AodvRoute> routes;
+    for (std::map<uint32_t, AodvRoute>::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+      {
+        routes.push_back (i->second);
+      }
+    return routes;
+  }
+
+  void Update (const AodvRoute &r)
+  {
+    m_routes[r.dst] = r;
+  }
+
+  void Advance (int64_t now)
+  {
+    for (std::map<uint32_t, AodvRoute>::iterator i = m_routes.begin (); i != m_routes.end (); )
+      {
+        if (i->second.expire > now)
+          {
+            ++i;
+          }
+        else if (i->second.state == AodvRoute::VALID)
+          {
+            i->second.state = AodvRoute::INVALID;
+            i->second.expire = now + DELETE_PERIOD;
+            ++i;
+          }
+        else
+          {
+            m_routes.erase (i++);
+          }
+      }
+  }
+
+private:
+  std::map<uint32_t, AodvRoute> m_routes;
+};
+
+struct BenchResult
+{
+  double insertMops;
+  double lookupMops;
+  double updateMops;
+  double expiryUs;
+  uint32_t finalSize;
+  uint64_t found;
+};
+
+static AodvRoute
+MakeRoute (uint32_t dst, int64_t now)
+{
+  AodvRoute r;
+  r.dst = dst;
+  r.nextHop = dst ^ 1;
+  r.seqNo = std::rand ();
+  r.hops = 1 + std::rand () % 8;
+  r.state = AodvRoute::VALID;
+  r.expire = now + 3000 * MS + std::rand () % (1000 * MS);
+  return r;
+}
+
+template <class Table>
+static BenchResult
+Run (Table &table, const std::vector<uint32_t> &dsts, uint32_t lookups, double seconds, uint32_t seed)
+{
+  BenchResult res;
+  std::srand (seed);
+  uint32_t n = dsts.size () - dsts.size () / 10;   // the rest are unknown
+
+  double start = WallClock ();
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      table.Update (MakeRoute (dsts[i], 0));
+    }
+  res.insertMops = n / (WallClock () - start) / 1e6;
+
+  std::vector<uint32_t> keys (lookups);
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      keys[i] = dsts[std::rand () % dsts.size ()];
+    }
+  res.found = 0;
+  start = WallClock ();
+  for (uint32_t i = 0; i < lookups; ++i)
+    {
+      const AodvRoute *r = table.Lookup (keys[i]);
+      if (r != 0 && r->state == AodvRoute::VALID)
+        {
+          res.found += r->hops;
+        }
+    }
+  res.lookupMops = lookups / (WallClock () - start) / 1e6;
+
+  uint32_t steps = uint32_t (seconds * 100);
+  uint32_t active = n / 2 + 1;
+  uint32_t perStep = n / 200 + 1;
+  double updateTime = 0;
+  double expiryTime = 0;
+  for (uint32_t s = 1; s <= steps; ++s)
+    {
+      int64_t now = s * 10 * MS;
+      start = WallClock ();
+      for (uint32_t k = 0; k < perStep; ++k)
+        {
+          table.Update (MakeRoute (dsts[std::rand () % active], now));
+        }
+      double mid = WallClock ();
+      table.Advance (now);
+      expiryTime += WallClock () - mid;
+      updateTime += mid - start;
+    }
+  res.updateMops = updateTime > 0 ? steps * double (perStep) / updateTime / 1e6 : 0;
+  res.expiryUs = steps > 0 ? expiryTime * 1e6 / steps : 0;
+  res.finalSize = table.Size ();
+  return res;
+}
+
+// Same destinations with the same next hop, state and expiry time
+static bool
+SameRoutes (const std::vector<AodvRoute> &a, const std::vector<AodvRoute> &b)
+{
+  if (a.size () != b.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < a.size (); ++i)
+    {
+      if (a[i].dst != b[i].dst || a[i].nextHop != b[i].nextHop
+          || a[i].state != b[i].state || a[i].expire != b[i].expire)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+static void
+Print (std::string name, uint32_t size, const BenchResult &r, bool match)
+{
+  std::cout << std::setw (8) << size << "  " << std::left << std::setw (6) << name << std::right
+            << std::fixed << std::setprecision (2)
+            << std::setw (10) << r.insertMops << std::setw (10) << r.lookupMops
+            << std::setw (10) << r.updateMops << std::setw (12) << r.expiryUs
+            << std::setw (10) << r.finalSize << "  " << (match ? "yes" : "NO") << "\n";
+}
+
+int main (int argc, char **argv)
+{
+  std::string sizes = "100,1000,10000,100000";
+  uint32_t lookups = 1000000;
+  double seconds = 20;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("sizes", "Comma separated table sizes", sizes);
+  cmd.AddValue ("lookups", "Lookups per size", lookups);
+  cmd.AddValue ("seconds", "Simulated seconds of route churn per size", seconds);
+  cmd.AddValue ("seed", "Random seed", seed);
+  cmd.Parse (argc, argv);
+
+  uint32_t failed = 0;
+  std::cout << "    size  table  insert/M  lookup/M  update/M   expiry us     final  match\n";
+  std::istringstream in (sizes);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      uint32_t size = std::atoi (item.c_str ());
+      if (size == 0)
+        {
+          continue;
+        }
+      // distinct addresses spread over 10.0.0.0/8, in random order
+      std::vector<uint32_t> dsts;
+      std::srand (seed);
+      std::map<uint32_t, bool> seen;
+      while (dsts.size () < size + size / 9)
+        {
+          uint32_t a = (10u << 24) | ((std::rand () & 0xffff) << 8) | (1 + std::rand () % 254);
+          if (!seen[a])
+            {
+              seen[a] = true;
+              dsts.push_back (a);
+            }
+        }
+
+      MapRouteTable map;
+      AodvHashTable hash (10 * MS, 1024, DELETE_PERIOD);
+      BenchResult m = Run (map, dsts, lookups, seconds, seed);
+      BenchResult h = Run (hash, dsts, lookups, seconds, seed);
+      bool match = m.found == h.found && SameRoutes (map.GetRoutes (), hash.GetRoutes ());
+      failed += !match;
+      Print ("map", size, m, match);
+      Print ("hash", size, h, match);
+    }
+  return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,234 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef BATCHED_LOSS_MODEL_H
+#define BATCHED_LOSS_MODEL_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+namespace ns3 {
+
+/*
+ * Friis or log-distance loss, computed for all receivers of a
+ * transmission at once.  Both models are
+ *
+ *   loss = max (a + b * log10 (d^2), floor)
+ *
+ * Friis:        a = 10 log10 (16 pi^2 L / lambda^2), b = 10, floor = MinLoss
+ * log-distance: a = L0 - 5 n log10 (d0^2), b = 5 n, floor = L0
+ *
+ * (for log-distance the floor is exactly the d <= d0 case).  YansWifiChannel
+ * asks for one receiver at a time; the first call of a transmission, i.e.
+ * a new (sender, time) pair, reads the positions of all nodes and computes
+ * the loss to every one of them in a single pass, and the calls for the
+ * other receivers of the same transmission are array lookups.  The pass
+ * works on floats, four at a time with SSE2 where the compiler targets it:
+ * log2 is the exponent plus an odd polynomial in t = (m - 1) / (m + 1) of
+ * the mantissa m in [sqrt(1/2), sqrt(2)), whose truncation error is below
+ * 1e-7 in log2.  The result stays within 0.001 dB of the double precision
+ * models for distances from 1 cm to 100 km; loss-bench checks this against
+ * the ns-3 models and measures the throughput of both.
+ */
+class BatchedLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::BatchedLossModel")
+      .SetParent (PropagationLossModel::GetTypeId ())
+      .AddConstructor<BatchedLossModel> ();
+    return tid;
+  }
+
+  // Friis with the ns-3 defaults
+  BatchedLossModel ()
+    : m_sender (~0u),
+      m_time (-1)
+  {
+    SetFriis (5.15e9, 1.0, 0.0);
+  }
+
+  // Same parameters as FriisPropagationLossModel
+  void SetFriis (double frequency, double systemLoss, double minLoss)
+  {
+    double lambda = 299792458.0 / frequency;
+    m_a = 10 * std::log10 (16 * M_PI * M_PI * systemLoss / (lambda * lambda));
+    m_b = 10;
+    m_floor = minLoss;
+    m_time = -1;
+  }
+
+  // Same parameters as LogDistancePropagationLossModel
+  void SetLogDistance (double exponent, double referenceDistance, double referenceLoss)
+  {
+    m_a = referenceLoss - 5 * exponent * std::log10 (referenceDistance * referenceDistance);
+    m_b = 5 * exponent;
+    m_floor = referenceLoss;
+    m_time = -1;
+  }
+
+  // loss[i] for the squared distances d2[i]
+  void ComputeLoss (const float *d2, uint32_t n, float *loss) const
+  {
+    const float b = m_b * 0.30102999566f;   // log10 (x) = log10 (2) log2 (x)
+    uint32_t i = 0;
+#ifdef __SSE2__
+    const __m128 va = _mm_set1_ps (m_a);
+    const __m128 vb = _mm_set1_ps (b);
+    const __m128 vfloor = _mm_set1_ps (m_floor);
+    for (; i + 4 <= n; i += 4)
+      {
+        __m128 l = _mm_add_ps (va, _mm_mul_ps (vb, Log2 (_mm_loadu_ps (d2 + i))));
+        _mm_storeu_ps (loss + i, _mm_max_ps (l, vfloor));
+      }
+#endif
+    for (; i < n; ++i)
+      {
+        loss[i] = std::max (float (m_a) + b * Log2 (d2[i]), float (m_floor));
+      }
+  }
+
+  // The double precision loss, as the ns-3 models compute it
+  double ReferenceLoss (double d2) const
+  {
+    return d2 > 0 ? std::max (m_a + m_b * std::log10 (d2), m_floor) : m_floor;
+  }
+
+private:
+  // 2 atanh (t) / ln 2 = log2 ((1 + t) / (1 - t)), truncated after t^7
+  static float Log2Poly (float t, float t2)
+  {
+    return t * (2.88539008f + t2 * (0.96179669f + t2 * (0.57707802f + t2 * 0.41219858f)));
+  }
+
+  static float Log2 (float x)
+  {
+    uint32_t bits;
+    std::memcpy (&bits, &x, sizeof (bits));
+    int32_t e = int32_t (bits >> 23) - 127;
+    bits = (bits & 0x007fffff) | 0x3f800000;
+    float m;
+    std::memcpy (&m, &bits, sizeof (m));
+    if (m > 1.41421356f)
+      {
+        m *= 0.5f;
+        ++e;
+      }
+    float t = (m - 1) / (m + 1);
+    return e + Log2Poly (t, t * t);
+  }
+
+#ifdef __SSE2__
+  static __m128 Log2 (__m128 x)
+  {
+    const __m128 one = _mm_set1_ps (1.0f);
+    __m128i bits = _mm_castps_si128 (x);
+    __m128i e = _mm_sub_epi32 (_mm_srli_epi32 (bits, 23), _mm_set1_epi32 (127));
+    __m128 m = _mm_castsi128_ps (_mm_or_si128 (_mm_and_si128 (bits, _mm_set1_epi32 (0x007fffff)),
+                                               _mm_set1_epi32 (0x3f800000)));
+    __m128 big = _mm_cmpgt_ps (m, _mm_set1_ps (1.41421356f));
+    m = _mm_sub_ps (m, _mm_and_ps (big, _mm_mul_ps (m, _mm_set1_ps (0.5f))));
+    e = _mm_sub_epi32 (e, _mm_castps_si128 (big));   // the mask is -1
+    __m128 t = _mm_div_ps (_mm_sub_ps (m, one), _mm_add_ps (m, one));
+    __m128 t2 = _mm_mul_ps (t, t);
+    __m128 p = _mm_add_ps (_mm_set1_ps (0.57707802f), _mm_mul_ps (t2, _mm_set1_ps (0.41219858f)));
+    p = _mm_add_ps (_mm_set1_ps (0.96179669f), _mm_mul_ps (t2, p));
+    p = _mm_add_ps (_mm_set1_ps (2.88539008f), _mm_mul_ps (t2, p));   // Log2Poly, four lanes
+    return _mm_add_ps (_mm_cvtepi32_ps (e), _mm_mul_ps (t, p));
+  }
+#endif
+
+  // Loss from sender to every node, indexed by node id
+  void ComputeBatch (uint32_t sender) const
+  {
+    uint32_t n = NodeList::GetNNodes ();
+    if (m_mobility.size () != n)
+      {
+        m_mobility.resize (n);
+        for (uint32_t i = 0; i < n; ++i)
+          {
+            m_mobility[i] = NodeList::GetNode (i)->GetObject<MobilityModel> ();
+          }
+        m_d2.resize (n);
+        m_loss.resize (n);
+      }
+    Vector s = m_mobility[sender]->GetPosition ();
+    for (uint32_t i = 0; i < n; ++i)
+      {
+        if (m_mobility[i] == 0)
+          {
+            m_d2[i] = 0;
+            continue;
+          }
+        Vector r = m_mobility[i]->GetPosition ();
+        double dx = r.x - s.x, dy = r.y - s.y, dz = r.z - s.z;
+        m_d2[i] = dx * dx + dy * dy + dz * dz;
+      }
+    ComputeLoss (&m_d2[0], n, &m_loss[0]);
+  }
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    uint32_t sender = a->GetObject<Node> ()->GetId ();
+    int64_t now = Simulator::Now ().GetTimeStep ();
+    if (sender != m_sender || now != m_time)
+      {
+        ComputeBatch (sender);
+        m_sender = sender;
+        m_time = now;
+      }
+    return txPowerDbm - m_loss[b->GetObject<Node> ()->GetId ()];
+  }
+
+  virtual int64_t DoAssignStreams (int64_t)
+  {
+    return 0;
+  }
+
+  // The mobility pointers would keep every node's aggregate alive
+  virtual void DoDispose (void)
+  {
+    m_mobility.clear ();
+    m_sender = ~0u;
+    m_time = -1;
+    PropagationLossModel::DoDispose ();
+  }
+
+  double m_a;
+  double m_b;
+  double m_floor;
+  mutable uint32_t m_sender;     // batch in m_loss: sender node and time step
+  mutable int64_t m_time;
+  mutable std::vector<Ptr<MobilityModel> > m_mobility;   // by node id
+  mutable std::vector<float> m_d2;
+  mutable std::vector<float> m_loss;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (BatchedLossModel);
+
+} // namespace ns3
+
+#endif /* BATCHED_LOSS_MODEL_H */
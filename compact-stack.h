@@ -0,0 +1,110 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef COMPACT_STACK_H
+#define COMPACT_STACK_H
+
+#include <iostream>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "wall-clock.h"
+
+namespace ns3 {
+
+/*
+ * Drop-in for InternetStackHelper in the MANET scenarios, selected with
+ * --stack=full|compact.  full is the stock helper.  compact installs only
+ * what UDP over IPv4 with a MANET routing protocol uses: ARP, IPv4, ICMPv4
+ * (IPv4 reports TTL expiry through it) and UDP, plus the traffic control
+ * layer on ns-3 versions whose IPv4 interfaces require it.  IPv6, TCP and
+ * the packet socket factory are left out.  Without a routing helper the
+ * nodes get static routing alone instead of the default static + global
+ * routing list, whose per-node global router is never used by ad hoc
+ * routing.  Install () prints the setup time of either profile.
+ */
+class CompactStackHelper
+{
+public:
+  CompactStackHelper (bool compact)
+    : m_compact (compact),
+      m_routing (0)
+  {
+  }
+
+  ~CompactStackHelper ()
+  {
+    delete m_routing;
+  }
+
+  void SetRoutingHelper (const Ipv4RoutingHelper &routing)
+  {
+    m_full.SetRoutingHelper (routing);
+    delete m_routing;
+    m_routing = routing.Copy ();
+  }
+
+  void Install (NodeContainer nodes) const
+  {
+    double start = WallClock ();
+    if (!m_compact)
+      {
+        m_full.Install (nodes);
+      }
+    else
+      {
+        Ipv4StaticRoutingHelper staticRouting;
+        const Ipv4RoutingHelper &routing = m_routing != 0 ? *m_routing : staticRouting;
+        TypeId tc;
+        bool needsTc = TypeId::LookupByNameFailSafe ("ns3::TrafficControlLayer", &tc);
+        for (uint32_t i = 0; i < nodes.GetN (); ++i)
+          {
+            Ptr<Node> node = nodes.Get (i);
+            NS_ABORT_MSG_IF (node->GetObject<Ipv4> () != 0, "Node " << node->GetId () << " already has an IPv4 stack");
+            if (needsTc)
+              {
+                Aggregate (node, "ns3::TrafficControlLayer");
+              }
+            Aggregate (node, "ns3::ArpL3Protocol");
+            Aggregate (node, "ns3::Ipv4L3Protocol");
+            Aggregate (node, "ns3::Icmpv4L4Protocol");
+            node->GetObject<Ipv4> ()->SetRoutingProtocol (routing.Create (node));
+            Aggregate (node, "ns3::UdpL4Protocol");
+          }
+      }
+    std::cout << "   " << (m_compact ? "Compact" : "Full") << " internet stack on " << nodes.GetN ()
+              << " nodes in " << WallClock () - start << " s\n";
+  }
+
+private:
+  CompactStackHelper (const CompactStackHelper &);
+  CompactStackHelper &operator= (const CompactStackHelper &);
+
+  static void Aggregate (Ptr<Node> node, std::string typeId)
+  {
+    ObjectFactory factory;
+    factory.SetTypeId (typeId);
+    node->AggregateObject (factory.Create<Object> ());
+  }
+
+  bool m_compact;
+  InternetStackHelper m_full;
+  Ipv4RoutingHelper *m_routing;
+};
+
+} // namespace ns3
+
+#endif /* COMPACT_STACK_H */
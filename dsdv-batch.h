@@ -0,0 +1,289 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DSDV_BATCH_H
+#define DSDV_BATCH_H
+
+#include <algorithm>
+#include <stdint.h>
+#include <vector>
+
+namespace ns3 {
+
+/// One destination of a DSDV update
+struct DsdvAdvert
+{
+  uint32_t dst;       // IPv4 address, host order
+  uint32_t seqNo;     // even: reachable, odd: broken link
+  uint32_t metric;    // hops, DSDV_INFINITY when unreachable
+};
+
+static const uint32_t DSDV_INFINITY = 255;
+
+/*
+ * Binary form of a whole DSDV update, replacing one 12 byte DsdvHeader per
+ * destination: an entry count, then per destination (in address order)
+ * the gap to the previous address and the sequence number as varints and
+ * the metric as one byte.  Node addresses of a scenario share one subnet,
+ * so an entry takes 4-6 bytes.  Decode () refills the caller's vector, so
+ * a receiver that keeps one vector allocates nothing per entry.
+ */
+class DsdvUpdateBatch
+{
+public:
+  static void Encode (const std::vector<DsdvAdvert> &adverts, std::vector<uint8_t> &out)
+  {
+    out.clear ();
+    PutVarint (out, adverts.size ());
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < adverts.size (); ++i)
+      {
+        PutVarint (out, adverts[i].dst - prev);
+        PutVarint (out, adverts[i].seqNo);
+        out.push_back (uint8_t (std::min (adverts[i].metric, DSDV_INFINITY)));
+        prev = adverts[i].dst;
+      }
+  }
+
+  // False on a truncated or malformed update
+  static bool Decode (const uint8_t *data, uint32_t size, std::vector<DsdvAdvert> &adverts)
+  {
+    const uint8_t *end = data + size;
+    uint32_t count;
+    adverts.clear ();
+    if (!GetVarint (data, end, count) || count > size)
+      {
+        return false;
+      }
+    adverts.resize (count);
+    uint32_t prev = 0;
+    for (uint32_t i = 0; i < count; ++i)
+      {
+        uint32_t gap;
+        if (!GetVarint (data, end, gap) || !GetVarint (data, end, adverts[i].seqNo) || data == end)
+          {
+            adverts.clear ();
+            return false;
+          }
+        adverts[i].dst = prev + gap;
+        adverts[i].metric = *data++;
+        prev = adverts[i].dst;
+      }
+    return true;
+  }
+
+private:
+  static void PutVarint (std::vector<uint8_t> &out, uint32_t v)
+  {
+    while (v >= 0x80)
+      {
+        out.push_back (uint8_t (v | 0x80));
+        v >>= 7;
+      }
+    out.push_back (uint8_t (v));
+  }
+
+  static bool GetVarint (const uint8_t *&data, const uint8_t *end, uint32_t &v)
+  {
+    v = 0;
+    for (uint32_t shift = 0; shift < 35 && data != end; shift += 7)
+      {
+        uint8_t b = *data++;
+        v |= uint32_t (b & 0x7f) << shift;
+        if (!(b & 0x80))
+          {
+            return true;
+          }
+      }
+    return false;
+  }
+};
+
+/*
+ * DSDV routing table kept as one vector sorted by destination.  Merge ()
+ * applies a whole neighbour update, itself sorted by destination, in a
+ * single pass over both: known destinations are updated in place and
+ * unknown ones are appended and merged in once at the end, so a periodic
+ * full dump costs O(table + update) with no per-entry allocation instead
+ * of one map lookup and one RoutingTableEntry per advertised destination.
+ * The acceptance rules are those of ns-3's dsdv::RoutingProtocol: a newer
+ * sequence number wins, an equal one wins with a shorter path, and the
+ * current next hop may always update its own routes.
+ */
+class DsdvBatchTable
+{
+public:
+  struct Entry
+  {
+    uint32_t dst;
+    uint32_t nextHop;
+    uint32_t seqNo;
+    uint32_t metric;
+    bool changed;       // since the last incremental dump
+  };
+
+  DsdvBatchTable (uint32_t self)
+    : m_self (self),
+      m_messages (0),
+      m_adverts (0)
+  {
+    Entry own = { self, self, 0, 0, true };
+    m_entries.push_back (own);
+  }
+
+  // Starts a new period: the own entry gets the next even sequence number
+  void NewSequence ()
+  {
+    Entry *own = Find (m_self);
+    own->seqNo += 2;
+    own->changed = true;
+  }
+
+  // Returns the number of routes that changed
+  uint32_t Merge (uint32_t neighbor, const std::vector<DsdvAdvert> &adverts)
+  {
+    uint32_t changed = 0;
+    uint32_t known = m_entries.size ();
+    uint32_t e = 0;
+    for (uint32_t a = 0; a < adverts.size (); ++a)
+      {
+        const DsdvAdvert &adv = adverts[a];
+        if (adv.dst == m_self)
+          {
+            continue;
+          }
+        while (e < known && m_entries[e].dst < adv.dst)
+          {
+            ++e;
+          }
+        uint32_t metric = adv.metric >= DSDV_INFINITY ? DSDV_INFINITY : adv.metric + 1;
+        if (e < known && m_entries[e].dst == adv.dst)
+          {
+            Entry &cur = m_entries[e];
+            int32_t newer = int32_t (adv.seqNo - cur.seqNo);
+            if (newer > 0 || (newer == 0 && metric < cur.metric)
+                || (newer == 0 && cur.nextHop == neighbor && metric != cur.metric))
+              {
+                cur.nextHop = neighbor;
+                cur.seqNo = adv.seqNo;
+                cur.metric = metric;
+                cur.changed = true;
+                ++changed;
+              }
+          }
+        else if (metric < DSDV_INFINITY)
+          {
+            Entry fresh = { adv.dst, neighbor, adv.seqNo, metric, true };
+            m_entries.push_back (fresh);
+            ++changed;
+          }
+      }
+    if (m_entries.size () > known)
+      {
+        std::inplace_merge (m_entries.begin (), m_entries.begin () + known, m_entries.end (), ByDst);
+      }
+    ++m_messages;
+    m_adverts += adverts.size ();
+    return changed;
+  }
+
+  // Marks every route through neighbor as broken, as on a lost link
+  void LinkBroken (uint32_t neighbor)
+  {
+    for (uint32_t i = 0; i < m_entries.size (); ++i)
+      {
+        Entry &r = m_entries[i];
+        if (r.nextHop == neighbor && r.dst != m_self && r.metric < DSDV_INFINITY)
+          {
+            r.seqNo |= 1;
+            r.metric = DSDV_INFINITY;
+            r.changed = true;
+          }
+      }
+  }
+
+  // Every route; a periodic update
+  void FullDump (std::vector<DsdvAdvert> &out)
+  {
+    out.clear ();
+    for (uint32_t i = 0; i < m_entries.size (); ++i)
+      {
+        Append (out, m_entries[i]);
+      }
+  }
+
+  // The routes changed since the last dump; a triggered update
+  void IncrementalDump (std::vector<DsdvAdvert> &out)
+  {
+    out.clear ();
+    for (uint32_t i = 0; i < m_entries.size (); ++i)
+      {
+        if (m_entries[i].changed)
+          {
+            Append (out, m_entries[i]);
+          }
+      }
+  }
+
+  const Entry *Lookup (uint32_t dst) const
+  {
+    return const_cast<DsdvBatchTable *> (this)->Find (dst);
+  }
+
+  uint32_t GetSize () const
+  {
+    return m_entries.size ();
+  }
+
+  uint64_t GetMessages () const
+  {
+    return m_messages;
+  }
+
+  uint64_t GetAdverts () const
+  {
+    return m_adverts;
+  }
+
+private:
+  static bool ByDst (const Entry &a, const Entry &b)
+  {
+    return a.dst < b.dst;
+  }
+
+  static void Append (std::vector<DsdvAdvert> &out, Entry &e)
+  {
+    DsdvAdvert adv = { e.dst, e.seqNo, e.metric };
+    out.push_back (adv);
+    e.changed = false;
+  }
+
+  Entry *Find (uint32_t dst)
+  {
+    Entry key = { dst, 0, 0, 0, false };
+    std::vector<Entry>::iterator i = std::lower_bound (m_entries.begin (), m_entries.end (), key, ByDst);
+    return i != m_entries.end () && i->dst == dst ? &*i : 0;
+  }
+
+  uint32_t m_self;
+  std::vector<Entry> m_entries;
+  uint64_t m_messages;
+  uint64_t m_adverts;
+};
+
+} // namespace ns3
+
+#endif /* DSDV_BATCH_H */
@@ -0,0 +1,323 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * DSDV update processing benchmark: batched updates (dsdv-batch.h) against
+ * the per-entry processing of ns-3's dsdv::RoutingProtocol.
+ *
+ * --nNodes nodes are placed at random with --range metres of radio range
+ * and about 8 neighbours each.  Every period each node takes a new
+ * sequence number and broadcasts a full dump of its table to its
+ * neighbours, then every node whose table changed sends an incremental
+ * update.  The per-entry side keeps its table in a map of heap allocated
+ * entries, carries one list element per advertised destination (one
+ * DsdvHeader each in ns-3) and builds a candidate entry for every one it
+ * receives, as RecvDsdv () does.  The batched side encodes one
+ * DsdvUpdateBatch per update, and each receiver decodes it into a reused
+ * vector and merges it into its sorted table in one pass.  Both see the
+ * same updates in the same order, so they must converge to the same
+ * routes; the last line says whether they do, and the exit status is 1
+ * if they do not or if a batch fails to decode.  us/update msg is the CPU
+ * time per received update, decoding included on the batched side, taken
+ * once per broadcast around all of its receivers.
+ *
+ * ./waf --run "dsdv-update-bench --nNodes=500 --periods=10"
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <list>
+#include <map>
+#include <vector>
+#include "ns3/core-module.h"
+#include "dsdv-batch.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+/// Per-entry layout: map of heap entries, one message element per entry
+class MapDsdvTable
+{
+public:
+  struct Entry
+  {
+    uint32_t nextHop;
+    uint32_t seqNo;
+    uint32_t metric;
+    bool changed;
+  };
+
+  MapDsdvTable (uint32_t self)
+    : m_self (self)
+  {
+    Entry *own = new Entry;
+    own->nextHop = self;
+    own->seqNo = 0;
+    own->metric = 0;
+    own->changed = true;
+    m_entries[self] = own;
+  }
+
+  ~MapDsdvTable ()
+  {
+    for (std::map<uint32_t, Entry *>::iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+      {
+        delete i->second;
+      }
+  }
+
+  void NewSequence ()
+  {
+    m_entries[m_self]->seqNo += 2;
+    m_entries[m_self]->changed = true;
+  }
+
+  void Merge (uint32_t neighbor, const std::list<DsdvAdvert> &adverts)
+  {
+    for (std::list<DsdvAdvert>::const_iterator a = adverts.begin (); a != adverts.end (); ++a)
+      {
+        if (a->dst == m_self)
+          {
+            continue;
+          }
+        Entry *fresh = new Entry;
+        fresh->nextHop = neighbor;
+        fresh->seqNo = a->seqNo;
+        fresh->metric = a->metric >= DSDV_INFINITY ? DSDV_INFINITY : a->metric + 1;
+        fresh->changed = true;
+        std::map<uint32_t, Entry *>::iterator i = m_entries.find (a->dst);
+        if (i == m_entries.end ())
+          {
+            if (fresh->metric < DSDV_INFINITY)
+              {
+                m_entries[a->dst] = fresh;
+                continue;
+              }
+          }
+        else
+          {
+            Entry *cur = i->second;
+            int32_t newer = int32_t (fresh->seqNo - cur->seqNo);
+            if (newer > 0 || (newer == 0 && fresh->metric < cur->metric)
+                || (newer == 0 && cur->nextHop == neighbor && fresh->metric != cur->metric))
+              {
+                i->second = fresh;
+                delete cur;
+                continue;
+              }
+          }
+        delete fresh;
+      }
+  }
+
+  void Dump (std::list<DsdvAdvert> &out, bool full)
+  {
+    out.clear ();
+    for (std::map<uint32_t, Entry *>::iterator i = m_entries.begin (); i != m_entries.end (); ++i)
+      {
+        if (full || i->second->changed)
+          {
+            DsdvAdvert adv = { i->first, i->second->seqNo, i->second->metric };
+            out.push_back (adv);
+            i->second->changed = false;
+          }
+      }
+  }
+
+  uint32_t GetMetric (uint32_t dst) const
+  {
+    std::map<uint32_t, Entry *>::const_iterator i = m_entries.find (dst);
+    return i == m_entries.end () ? DSDV_INFINITY : i->second->metric;
+  }
+
+private:
+  uint32_t m_self;
+  std::map<uint32_t, Entry *> m_entries;
+};
+
+// Seconds of CPU time per received update message
+static double
+CpuPerMessage (std::clock_t cpu, uint64_t messages)
+{
+  return messages == 0 ? 0 : double (cpu) / CLOCKS_PER_SEC / messages;
+}
+
+static uint32_t
+NodeAddress (uint32_t node)
+{
+  return (10u << 24) | (1u << 16) | (node + 1);   // 10.1.x.y, as the scenarios assign
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nNodes = 500;
+  uint32_t periods = 10;
+  double range = 250;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("nNodes", "Number of nodes", nNodes);
+  cmd.AddValue ("periods", "Periodic updates to run", periods);
+  cmd.AddValue ("range", "Radio range in metres", range);
+  cmd.AddValue ("seed", "Random seed", seed);
+  cmd.Parse (argc, argv);
+
+  // about 8 neighbours per node
+  double side = std::sqrt (nNodes * M_PI * range * range / 8);
+  std::srand (seed);
+  std::vector<double> x (nNodes), y (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      x[i] = side * std::rand () / RAND_MAX;
+      y[i] = side * std::rand () / RAND_MAX;
+    }
+  std::vector<std::vector<uint32_t> > neighbors (nNodes);
+  uint64_t links = 0;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      for (uint32_t j = 0; j < nNodes; ++j)
+        {
+          if (i != j && (x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]) <= range * range)
+            {
+              neighbors[i].push_back (j);
+              ++links;
+            }
+        }
+    }
+
+  // per-entry processing
+  std::vector<MapDsdvTable *> maps;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      maps.push_back (new MapDsdvTable (NodeAddress (i)));
+    }
+  std::list<DsdvAdvert> list;
+  uint64_t mapBytes = 0, mapMessages = 0, mapReceived = 0;
+  std::clock_t mapCpu = 0;
+  double start = WallClock ();
+  for (uint32_t p = 0; p < periods; ++p)
+    {
+      for (uint32_t round = 0; round < 2; ++round)
+        {
+          for (uint32_t i = 0; i < nNodes; ++i)
+            {
+              if (round == 0)
+                {
+                  maps[i]->NewSequence ();
+                }
+              maps[i]->Dump (list, round == 0);
+              if (list.empty ())
+                {
+                  continue;
+                }
+              mapBytes += 12 * list.size ();
+              ++mapMessages;
+              // one clock read per broadcast, not per received message
+              std::clock_t cpu = std::clock ();
+              for (uint32_t k = 0; k < neighbors[i].size (); ++k)
+                {
+                  maps[neighbors[i][k]]->Merge (NodeAddress (i), list);
+                }
+              mapCpu += std::clock () - cpu;
+              mapReceived += neighbors[i].size ();
+            }
+        }
+    }
+  double mapTime = WallClock () - start;
+
+  // batched processing
+  std::vector<DsdvBatchTable *> tables;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      tables.push_back (new DsdvBatchTable (NodeAddress (i)));
+    }
+  std::vector<DsdvAdvert> dump, received;
+  std::vector<uint8_t> wire;
+  uint64_t batchBytes = 0, batchMessages = 0, batchReceived = 0;
+  std::clock_t batchCpu = 0;
+  bool decoded = true;
+  start = WallClock ();
+  for (uint32_t p = 0; p < periods; ++p)
+    {
+      for (uint32_t round = 0; round < 2; ++round)
+        {
+          for (uint32_t i = 0; i < nNodes; ++i)
+            {
+              if (round == 0)
+                {
+                  tables[i]->NewSequence ();
+                  tables[i]->FullDump (dump);
+                }
+              else
+                {
+                  tables[i]->IncrementalDump (dump);
+                }
+              if (dump.empty ())
+                {
+                  continue;
+                }
+              DsdvUpdateBatch::Encode (dump, wire);
+              batchBytes += wire.size ();
+              ++batchMessages;
+              std::clock_t cpu = std::clock ();
+              for (uint32_t k = 0; k < neighbors[i].size (); ++k)
+                {
+                  decoded &= DsdvUpdateBatch::Decode (&wire[0], wire.size (), received);
+                  tables[neighbors[i][k]]->Merge (NodeAddress (i), received);
+                }
+              batchCpu += std::clock () - cpu;
+              batchReceived += neighbors[i].size ();
+            }
+        }
+    }
+  double batchTime = WallClock () - start;
+  if (!decoded)
+    {
+      std::cout << "DsdvUpdateBatch::Decode rejected an encoded update\n";
+      return 1;
+    }
+
+  bool match = true;
+  uint64_t routes = 0;
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      routes += tables[i]->GetSize ();
+      for (uint32_t j = 0; j < nNodes; ++j)
+        {
+          const DsdvBatchTable::Entry *e = tables[i]->Lookup (NodeAddress (j));
+          if ((e == 0 ? DSDV_INFINITY : e->metric) != maps[i]->GetMetric (NodeAddress (j)))
+            {
+              match = false;
+            }
+        }
+      delete maps[i];
+      delete tables[i];
+    }
+
+  std::cout << nNodes << " nodes, " << double (links) / nNodes << " neighbours per node, "
+            << double (routes) / nNodes << " routes per node after " << periods << " periods\n"
+            << std::fixed << std::setprecision (2)
+            << "            wall s   us/update msg   bytes/msg\n"
+            << "per-entry " << std::setw (8) << mapTime << std::setw (16) << CpuPerMessage (mapCpu, mapReceived) * 1e6
+            << std::setw (12) << (mapMessages ? double (mapBytes) / mapMessages : 0) << "\n"
+            << "batched   " << std::setw (8) << batchTime << std::setw (16) << CpuPerMessage (batchCpu, batchReceived) * 1e6
+            << std::setw (12) << (batchMessages ? double (batchBytes) / batchMessages : 0) << "\n"
+            << "routes match: " << (match ? "yes" : "NO") << "\n";
+  return match ? 0 : 1;
+}
@@ -0,0 +1,374 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * DSR forwarding benchmark: route caches holding address vectors, as
+ * ns-3's dsr::RouteCache does, against DsrPathCache (dsr-path-cache.h).
+ *
+ * --nNodes nodes are placed at random with about 8 neighbours each and
+ * --flows random source/destination pairs get their shortest path.  As in
+ * DSR, the source caches the route and a route to every node along it.
+ *   forward  --packets packets, round robin over the flows: a cache lookup
+ *            at the source, then the source route travels with the packet
+ *            and every hop reads its next hop from it.  The vector cache
+ *            copies the route out of the cache and into each hop's packet
+ *            copy, the interned cache copies a DsrPathRef.
+ *   break    --breaks links of cached routes fail, each invalidating every
+ *            cached route through it
+ *   repair   the interned cache collects its dead paths, then every route
+ *            is cached again in both, reusing the freed trie nodes
+ * Both caches must return the same route for every node and destination
+ * after the breaks and after the repair; the last line says whether they
+ * do and the exit status is 1 if they do not.  The first line also gives
+ * the memory the interned cache holds for paths killed by the breaks, and
+ * what is left of it once collected.
+ *
+ * ./waf --run "dsr-forward-bench --nNodes=200 --flows=2000"
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <vector>
+#include "ns3/core-module.h"
+#include "dsr-path-cache.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+typedef std::vector<uint32_t> Path;
+
+/// Route cache of address vectors, scanned on a broken link
+class VectorRouteCache
+{
+public:
+  VectorRouteCache (uint32_t routesPerDst)
+    : m_routesPerDst (routesPerDst)
+  {
+  }
+
+  void AddRoute (uint32_t node, uint32_t dst, const Path &path)
+  {
+    std::vector<Path> &routes = m_routes[Key (node, dst)];
+    for (uint32_t i = 0; i < routes.size (); ++i)
+      {
+        if (routes[i] == path)
+          {
+            return;
+          }
+      }
+    uint32_t pos = routes.size ();
+    while (pos > 0 && routes[pos - 1].size () > path.size ())
+      {
+        --pos;
+      }
+    routes.insert (routes.begin () + pos, path);
+    if (routes.size () > m_routesPerDst)
+      {
+        routes.pop_back ();
+      }
+  }
+
+  // Copies the route out, as RouteCache::LookupRoute () fills a RouteCacheEntry
+  bool Lookup (uint32_t node, uint32_t dst, Path &route)
+  {
+    std::map<uint64_t, std::vector<Path> >::iterator i = m_routes.find (Key (node, dst));
+    if (i == m_routes.end () || i->second.empty ())
+      {
+        return false;
+      }
+    route = i->second.front ();
+    return true;
+  }
+
+  void LinkBroken (uint32_t from, uint32_t to)
+  {
+    for (std::map<uint64_t, std::vector<Path> >::iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+      {
+        std::vector<Path> &routes = i->second;
+        for (uint32_t r = 0; r < routes.size (); )
+          {
+            bool uses = false;
+            for (uint32_t h = 1; h < routes[r].size () && !uses; ++h)
+              {
+                uses = routes[r][h - 1] == from && routes[r][h] == to;
+              }
+            if (uses)
+              {
+                routes.erase (routes.begin () + r);
+              }
+            else
+              {
+                ++r;
+              }
+          }
+      }
+  }
+
+  uint64_t GetMemoryBytes () const
+  {
+    uint64_t bytes = 0;
+    for (std::map<uint64_t, std::vector<Path> >::const_iterator i = m_routes.begin (); i != m_routes.end (); ++i)
+      {
+        bytes += 48 + i->second.capacity () * sizeof (Path);
+        for (uint32_t r = 0; r < i->second.size (); ++r)
+          {
+            bytes += i->second[r].capacity () * sizeof (uint32_t);
+          }
+      }
+    return bytes;
+  }
+
+private:
+  static uint64_t Key (uint32_t node, uint32_t dst)
+  {
+    return (uint64_t (node) << 32) | dst;
+  }
+
+  uint32_t m_routesPerDst;
+  std::map<uint64_t, std::vector<Path> > m_routes;
+};
+
+static Path
+ShortestPath (const std::vector<std::vector<uint32_t> > &neighbors, uint32_t src, uint32_t dst)
+{
+  std::vector<uint32_t> parent (neighbors.size (), ~0u);
+  std::vector<uint32_t> queue (1, src);
+  parent[src] = src;
+  for (uint32_t q = 0; q < queue.size () && parent[dst] == ~0u; ++q)
+    {
+      uint32_t n = queue[q];
+      for (uint32_t k = 0; k < neighbors[n].size (); ++k)
+        {
+          if (parent[neighbors[n][k]] == ~0u)
+            {
+              parent[neighbors[n][k]] = n;
+              queue.push_back (neighbors[n][k]);
+            }
+        }
+    }
+  Path path;
+  if (parent[dst] == ~0u)
+    {
+      return path;
+    }
+  for (uint32_t n = dst; n != src; n = parent[n])
+    {
+      path.insert (path.begin (), n);
+    }
+  path.insert (path.begin (), src);
+  return path;
+}
+
+static void
+AddRoutes (const std::vector<Path> &paths, VectorRouteCache &vectors, DsrPathCache &interned)
+{
+  for (uint32_t f = 0; f < paths.size (); ++f)
+    {
+      const Path &p = paths[f];
+      for (uint32_t k = 1; k < p.size (); ++k)
+        {
+          Path prefix (p.begin (), p.begin () + k + 1);
+          vectors.AddRoute (p[0], p[k], prefix);
+          interned.AddRoute (p[0], p[k], interned.Intern (prefix));
+        }
+    }
+}
+
+// Same route in both caches for every node and destination, read both ways
+static bool
+SameRoutes (uint32_t nNodes, VectorRouteCache &vectors, DsrPathCache &interned)
+{
+  for (uint32_t n = 0; n < nNodes; ++n)
+    {
+      for (uint32_t d = 0; d < nNodes; ++d)
+        {
+          Path a, b;
+          bool hasA = vectors.Lookup (n, d, a);
+          uint32_t id = interned.Lookup (n, d);
+          if (id != DsrPathCache::NONE)
+            {
+              interned.BuildRoute (id, b);
+            }
+          if (hasA != (id != DsrPathCache::NONE) || a != b)
+            {
+              return false;
+            }
+          for (uint32_t k = 0; k < b.size (); ++k)
+            {
+              if (interned.GetHop (id, k) != b[k])
+                {
+                  return false;
+                }
+            }
+        }
+    }
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t nNodes = 200;
+  uint32_t flows = 2000;
+  uint32_t packets = 1000000;
+  uint32_t breaks = 200;
+  uint32_t routesPerDst = 3;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("nNodes", "Number of nodes", nNodes);
+  cmd.AddValue ("flows", "Source/destination pairs", flows);
+  cmd.AddValue ("packets", "Packets to forward", packets);
+  cmd.AddValue ("breaks", "Links to break", breaks);
+  cmd.AddValue ("routesPerDst", "Routes cached per destination", routesPerDst);
+  cmd.AddValue ("seed", "Random seed", seed);
+  cmd.Parse (argc, argv);
+
+  // about 8 neighbours per node, unit radio range
+  double side = std::sqrt (nNodes * M_PI / 8);
+  std::srand (seed);
+  std::vector<double> x (nNodes), y (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      x[i] = side * std::rand () / RAND_MAX;
+      y[i] = side * std::rand () / RAND_MAX;
+    }
+  std::vector<std::vector<uint32_t> > neighbors (nNodes);
+  for (uint32_t i = 0; i < nNodes; ++i)
+    {
+      for (uint32_t j = 0; j < nNodes; ++j)
+        {
+          if (i != j && (x[i] - x[j]) * (x[i] - x[j]) + (y[i] - y[j]) * (y[i] - y[j]) <= 1)
+            {
+              neighbors[i].push_back (j);
+            }
+        }
+    }
+
+  std::vector<Path> paths;
+  for (uint32_t tries = 0; paths.size () < flows && tries < 100 * flows; ++tries)
+    {
+      Path p = ShortestPath (neighbors, std::rand () % nNodes, std::rand () % nNodes);
+      if (p.size () >= 2)
+        {
+          paths.push_back (p);
+        }
+    }
+
+  if (paths.empty ())
+    {
+      std::cout << "No connected node pairs\n";
+      return 1;
+    }
+
+  VectorRouteCache vectors (routesPerDst);
+  DsrPathCache interned (routesPerDst);
+  AddRoutes (paths, vectors, interned);
+  double hops = 0;
+  for (uint32_t f = 0; f < paths.size (); ++f)
+    {
+      hops += paths[f].size () - 1;
+    }
+
+  // forwarding, vector source routes
+  uint64_t vectorSum = 0;
+  double start = WallClock ();
+  for (uint32_t i = 0; i < packets; ++i)
+    {
+      const Path &p = paths[i % paths.size ()];
+      Path route;
+      vectors.Lookup (p[0], p.back (), route);
+      Path header (route);
+      for (uint32_t segmentsLeft = header.size () - 1; segmentsLeft > 0; --segmentsLeft)
+        {
+          Path copy (header);   // the header of each hop's packet copy
+          vectorSum += copy[copy.size () - segmentsLeft];
+          header.swap (copy);
+        }
+    }
+  double vectorTime = WallClock () - start;
+
+  // forwarding, interned paths
+  uint64_t internedSum = 0;
+  start = WallClock ();
+  for (uint32_t i = 0; i < packets; ++i)
+    {
+      const Path &p = paths[i % paths.size ()];
+      DsrPathRef header = { interned.Lookup (p[0], p.back ()), 0 };
+      header.segmentsLeft = interned.GetLength (header.path) - 1;
+      for ( ; header.segmentsLeft > 0; --header.segmentsLeft)
+        {
+          DsrPathRef copy = header;
+          internedSum += interned.GetHop (copy.path, interned.GetLength (copy.path) - copy.segmentsLeft);
+        }
+    }
+  double internedTime = WallClock () - start;
+
+  uint64_t vectorBytes = vectors.GetMemoryBytes ();
+  uint64_t internedBytes = interned.GetMemoryBytes ();
+
+  // link breaks on cached routes
+  std::vector<std::pair<uint32_t, uint32_t> > links;
+  for (uint32_t b = 0; b < breaks; ++b)
+    {
+      const Path &p = paths[std::rand () % paths.size ()];
+      uint32_t h = 1 + std::rand () % (p.size () - 1);
+      links.push_back (std::make_pair (p[h - 1], p[h]));
+    }
+  start = WallClock ();
+  for (uint32_t b = 0; b < links.size (); ++b)
+    {
+      vectors.LinkBroken (links[b].first, links[b].second);
+    }
+  double vectorBreak = WallClock () - start;
+  start = WallClock ();
+  for (uint32_t b = 0; b < links.size (); ++b)
+    {
+      interned.LinkBroken (links[b].first, links[b].second);
+    }
+  double internedBreak = WallClock () - start;
+
+  bool match = vectorSum == internedSum && SameRoutes (nNodes, vectors, interned);
+
+  // two packet lifetimes pass with no packet in flight, then the links are repaired
+  uint64_t deadBytes = interned.GetDeadBytes ();
+  interned.Collect ();
+  uint32_t freed = interned.Collect ();
+  uint64_t collectedBytes = interned.GetDeadBytes ();
+  uint64_t beforeRepair = interned.GetMemoryBytes ();
+  AddRoutes (paths, vectors, interned);
+  uint64_t afterRepair = interned.GetMemoryBytes ();
+  match = match && SameRoutes (nNodes, vectors, interned);
+
+  double hopCount = packets * hops / paths.size ();
+  std::cout << nNodes << " nodes, " << paths.size () << " flows, " << hops / paths.size ()
+            << " hops per route, " << interned.GetNPathNodes () << " live path nodes, "
+            << deadBytes / 1024.0 << " KiB dead after " << breaks << " link breaks, "
+            << collectedBytes / 1024.0 << " KiB once " << freed << " nodes are collected\n"
+            << std::fixed << std::setprecision (2)
+            << "          Mhops/s   us/break   cache KiB\n"
+            << "vector  " << std::setw (10) << hopCount / vectorTime / 1e6
+            << std::setw (11) << vectorBreak * 1e6 / std::max<uint32_t> (breaks, 1) << std::setw (12) << vectorBytes / 1024.0 << "\n"
+            << "interned" << std::setw (10) << hopCount / internedTime / 1e6
+            << std::setw (11) << internedBreak * 1e6 / std::max<uint32_t> (breaks, 1) << std::setw (12) << internedBytes / 1024.0 << "\n"
+            << "repair  " << std::setw (33) << afterRepair / 1024.0
+            << " (" << beforeRepair / 1024.0 << " before)\n"
+            << "routes match: " << (match ? "yes" : "NO") << "\n";
+  return match ? 0 : 1;
+}
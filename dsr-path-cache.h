@@ -0,0 +1,382 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef DSR_PATH_CACHE_H
+#define DSR_PATH_CACHE_H
+
+#include <algorithm>
+#include <map>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+namespace ns3 {
+
+/// Source route carried by a packet instead of a copy of the address list
+struct DsrPathRef
+{
+  uint32_t path;           // DsrPathCache path id
+  uint32_t segmentsLeft;   // as in the DSR source route option
+};
+
+/*
+ * DSR route caches of all nodes of a simulation, with interned paths.
+ * Every path is stored once, in a prefix trie shared by all nodes and
+ * destinations: a path id is the trie node of its last hop, so routes
+ * that share a prefix share its nodes, and a cache entry or a packet
+ * holds a 4 byte id instead of a vector of addresses.  The first time a
+ * path is forwarded on, its hops are laid out once in a flat array, so
+ * GetHop () is an array read and a forwarded packet copies only its
+ * DsrPathRef.  BuildRoute () fills a caller's vector where a real
+ * DsrOptionSRHeader has to be written.
+ *
+ * Each trie edge is indexed by its link, so LinkBroken () marks exactly
+ * the subtrees below that link dead, without scanning the whole cache as
+ * DeleteAllRoutesIncludeLink () does.  A path over a repaired link is
+ * interned again as new nodes.
+ *
+ * Packets in flight may still hold the id of a dead path and read its
+ * hops, so a dead node is not freed at once.  Cache entries count their
+ * references to each node, and Collect (), called at least one maximum
+ * packet lifetime apart, frees the dead nodes that no cache entry holds
+ * and that died before the previous Collect (): no packet can still
+ * carry them.  A node is freed only after its children, and Intern () and
+ * GetHop () reuse freed trie nodes and flat hops, so under link churn the
+ * cache stays the size of its live paths.  GetDeadBytes () gives what dead
+ * nodes still hold until they are collected.
+ */
+class DsrPathCache
+{
+public:
+  static const uint32_t NONE = 0;
+
+  DsrPathCache (uint32_t routesPerDst)
+    : m_routesPerDst (routesPerDst),
+      m_dead (0),
+      m_deadFlat (0),
+      m_epoch (0)
+  {
+    Hop root = { 0, NONE, NONE, NONE, 0, false, NOT_FLAT, 0 };
+    m_hops.push_back (root);
+  }
+
+  // Returns the id of path, which starts at the source
+  uint32_t Intern (const std::vector<uint32_t> &path)
+  {
+    uint32_t node = 0;
+    for (uint32_t i = 0; i < path.size (); ++i)
+      {
+        uint32_t child = m_hops[node].firstChild;
+        while (child != NONE && (m_hops[child].addr != path[i] || m_hops[child].dead))
+          {
+            child = m_hops[child].nextSibling;
+          }
+        if (child == NONE)
+          {
+            Hop hop = { path[i], node, NONE, m_hops[node].firstChild, uint16_t (i + 1), false, NOT_FLAT, 0 };
+            if (m_free.empty ())
+              {
+                child = m_hops.size ();
+                m_hops.push_back (hop);
+              }
+            else
+              {
+                child = m_free.back ();
+                m_free.pop_back ();
+                m_hops[child] = hop;
+              }
+            m_hops[node].firstChild = child;
+            if (i > 0)
+              {
+                m_links[LinkKey (path[i - 1], path[i])].push_back (child);
+              }
+          }
+        node = child;
+      }
+    return node;
+  }
+
+  uint32_t GetLength (uint32_t path) const
+  {
+    return m_hops[path].depth;
+  }
+
+  bool IsValid (uint32_t path) const
+  {
+    return path != NONE && !m_hops[path].dead;
+  }
+
+  // Address at position index of the path, 0 being the source
+  uint32_t GetHop (uint32_t path, uint32_t index)
+  {
+    if (m_hops[path].flat == NOT_FLAT)
+      {
+        std::vector<uint32_t> &free = m_freeFlat[m_hops[path].depth];
+        if (free.empty ())
+          {
+            m_hops[path].flat = m_flat.size ();
+            m_flat.resize (m_flat.size () + m_hops[path].depth);
+          }
+        else
+          {
+            m_hops[path].flat = free.back ();
+            free.pop_back ();
+          }
+        m_deadFlat += m_hops[path].dead ? m_hops[path].depth : 0;
+        for (uint32_t n = path; n != 0; n = m_hops[n].parent)
+          {
+            m_flat[m_hops[path].flat + m_hops[n].depth - 1] = m_hops[n].addr;
+          }
+      }
+    return m_flat[m_hops[path].flat + index];
+  }
+
+  void BuildRoute (uint32_t path, std::vector<uint32_t> &route) const
+  {
+    route.resize (m_hops[path].depth);
+    for (uint32_t n = path; n != 0; n = m_hops[n].parent)
+      {
+        route[m_hops[n].depth - 1] = m_hops[n].addr;
+      }
+  }
+
+  // Caches path for dst at node, keeping the routesPerDst shortest valid ones
+  void AddRoute (uint32_t node, uint32_t dst, uint32_t path)
+  {
+    std::vector<uint32_t> &routes = m_routes[LinkKey (node, dst)];
+    for (uint32_t i = 0; i < routes.size (); )
+      {
+        if (routes[i] == path)
+          {
+            return;
+          }
+        if (!IsValid (routes[i]))
+          {
+            --m_hops[routes[i]].refs;
+            routes.erase (routes.begin () + i);
+          }
+        else
+          {
+            ++i;
+          }
+      }
+    uint32_t pos = routes.size ();
+    while (pos > 0 && GetLength (routes[pos - 1]) > GetLength (path))
+      {
+        --pos;
+      }
+    routes.insert (routes.begin () + pos, path);
+    ++m_hops[path].refs;
+    if (routes.size () > m_routesPerDst)
+      {
+        --m_hops[routes.back ()].refs;
+        routes.pop_back ();
+      }
+  }
+
+  // Shortest valid path to dst cached at node, NONE if there is none
+  uint32_t Lookup (uint32_t node, uint32_t dst)
+  {
+    std::map<uint64_t, std::vector<uint32_t> >::iterator i = m_routes.find (LinkKey (node, dst));
+    if (i == m_routes.end ())
+      {
+        return NONE;
+      }
+    std::vector<uint32_t> &routes = i->second;
+    while (!routes.empty () && !IsValid (routes.front ()))
+      {
+        --m_hops[routes.front ()].refs;
+        routes.erase (routes.begin ());
+      }
+    return routes.empty () ? NONE : routes.front ();
+  }
+
+  // Invalidates every path using the link from to to; returns their trie nodes
+  uint32_t LinkBroken (uint32_t from, uint32_t to)
+  {
+    std::map<uint64_t, std::vector<uint32_t> >::iterator link = m_links.find (LinkKey (from, to));
+    if (link == m_links.end ())
+      {
+        return 0;
+      }
+    uint32_t marked = 0;
+    std::vector<uint32_t> stack (link->second);
+    m_links.erase (link);
+    while (!stack.empty ())
+      {
+        uint32_t n = stack.back ();
+        stack.pop_back ();
+        if (m_hops[n].dead)
+          {
+            continue;
+          }
+        m_hops[n].dead = true;
+        m_deadFlat += m_hops[n].flat != NOT_FLAT ? m_hops[n].depth : 0;
+        m_limbo.push_back (std::make_pair (m_epoch, n));
+        ++marked;
+        for (uint32_t c = m_hops[n].firstChild; c != NONE; c = m_hops[c].nextSibling)
+          {
+            stack.push_back (c);
+          }
+      }
+    m_dead += marked;
+    return marked;
+  }
+
+  /*
+   * Frees the dead trie nodes, and their flat hops, that died before the
+   * previous call and that no cache entry holds.  Must be called at least
+   * one maximum packet lifetime apart.  Returns the number of nodes freed.
+   */
+  uint32_t Collect ()
+  {
+    ++m_epoch;
+    // deepest first, so a node's children are gone before it is looked at
+    std::sort (m_limbo.begin (), m_limbo.end (), DeeperFirst (m_hops));
+    std::vector<std::pair<uint32_t, uint32_t> > kept;
+    uint32_t freed = 0;
+    for (uint32_t i = 0; i < m_limbo.size (); ++i)
+      {
+        uint32_t n = m_limbo[i].second;
+        if (m_limbo[i].first + 2 > m_epoch || m_hops[n].refs > 0 || m_hops[n].firstChild != NONE)
+          {
+            kept.push_back (m_limbo[i]);
+            continue;
+          }
+        Free (n);
+        ++freed;
+      }
+    m_limbo.swap (kept);
+    return freed;
+  }
+
+  // Live trie nodes; dead ones take memory until collected, see GetDeadBytes ()
+  uint32_t GetNPathNodes () const
+  {
+    return m_hops.size () - 1 - m_dead - m_free.size ();
+  }
+
+  // Part of GetMemoryBytes () held by dead trie nodes and their flat hops
+  uint64_t GetDeadBytes () const
+  {
+    return uint64_t (m_dead) * sizeof (Hop) + m_deadFlat * sizeof (uint32_t);
+  }
+
+  uint64_t GetMemoryBytes () const
+  {
+    uint64_t links = 0;
+    for (std::map<uint64_t, std::vector<uint32_t> >::const_iterator i = m_links.begin (); i != m_links.end (); ++i)
+      {
+        links += 48 + i->second.capacity () * sizeof (uint32_t);
+      }
+    uint64_t routes = m_routes.size () * (48 + m_routesPerDst * sizeof (uint32_t));
+    uint64_t freeLists = m_free.capacity () * sizeof (uint32_t) + m_limbo.capacity () * 2 * sizeof (uint32_t);
+    for (std::map<uint16_t, std::vector<uint32_t> >::const_iterator i = m_freeFlat.begin (); i != m_freeFlat.end (); ++i)
+      {
+        freeLists += 48 + i->second.capacity () * sizeof (uint32_t);
+      }
+    return m_hops.capacity () * sizeof (Hop) + m_flat.capacity () * sizeof (uint32_t) + links + routes + freeLists;
+  }
+
+private:
+  static const uint32_t NOT_FLAT = 0xffffffff;
+
+  struct Hop
+  {
+    uint32_t addr;
+    uint32_t parent;
+    uint32_t firstChild;
+    uint32_t nextSibling;
+    uint16_t depth;
+    bool dead;
+    uint32_t flat;       // offset of the path in m_flat
+    uint32_t refs;       // cache entries holding the path
+  };
+
+  struct DeeperFirst
+  {
+    DeeperFirst (const std::vector<Hop> &hops)
+      : m_hops (hops)
+    {
+    }
+    bool operator() (const std::pair<uint32_t, uint32_t> &l, const std::pair<uint32_t, uint32_t> &r) const
+    {
+      return m_hops[l.second].depth > m_hops[r.second].depth;
+    }
+    const std::vector<Hop> &m_hops;
+  };
+
+  static uint64_t LinkKey (uint32_t from, uint32_t to)
+  {
+    return (uint64_t (from) << 32) | to;
+  }
+
+  // Unlinks childless dead node n from its parent and its link and frees it
+  void Free (uint32_t n)
+  {
+    Hop &hop = m_hops[n];
+    uint32_t *link = &m_hops[hop.parent].firstChild;
+    while (*link != n)
+      {
+        link = &m_hops[*link].nextSibling;
+      }
+    *link = hop.nextSibling;
+    if (hop.depth > 1)
+      {
+        std::map<uint64_t, std::vector<uint32_t> >::iterator i =
+          m_links.find (LinkKey (m_hops[hop.parent].addr, hop.addr));
+        if (i != m_links.end ())
+          {
+            std::vector<uint32_t>::iterator k = std::find (i->second.begin (), i->second.end (), n);
+            if (k != i->second.end ())
+              {
+                *k = i->second.back ();
+                i->second.pop_back ();
+              }
+            if (i->second.empty ())
+              {
+                m_links.erase (i);
+              }
+          }
+      }
+    if (hop.flat != NOT_FLAT)
+      {
+        m_freeFlat[hop.depth].push_back (hop.flat);
+        m_deadFlat -= hop.depth;
+      }
+    hop.parent = NONE;
+    hop.nextSibling = NONE;
+    hop.flat = NOT_FLAT;
+    --m_dead;
+    m_free.push_back (n);
+  }
+
+  uint32_t m_routesPerDst;
+  uint32_t m_dead;
+  uint64_t m_deadFlat;     // words of m_flat belonging to dead paths
+  uint32_t m_epoch;        // Collect () calls so far
+  std::vector<Hop> m_hops;
+  std::vector<uint32_t> m_flat;
+  std::vector<uint32_t> m_free;                                // freed trie nodes
+  std::map<uint16_t, std::vector<uint32_t> > m_freeFlat;       // freed m_flat offsets by length
+  std::vector<std::pair<uint32_t, uint32_t> > m_limbo;         // dead nodes and the epoch they died in
+  std::map<uint64_t, std::vector<uint32_t> > m_links;
+  std::map<uint64_t, std::vector<uint32_t> > m_routes;   // by node and dst
+};
+
+} // namespace ns3
+
+#endif /* DSR_PATH_CACHE_H */
@@ -0,0 +1,350 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_POOL_H
+#define EVENT_POOL_H
+
+#include <iostream>
+#include <new>
+#include <vector>
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+/*
+ * Pooled EventImpl allocation for events scheduled from the scripts.
+ *
+ * PooledSchedule (delay, &f, args...) is a drop-in for Simulator::Schedule
+ * with a free function.  The EventImpl it creates is a PooledFunctionEvent,
+ * whose operator new/delete use a free list of its own type: once the pool
+ * is warm a reschedule costs no malloc/free at all.  Fresh blocks come from
+ * the heap, or with EventPool::SetArena (true) from 64 KiB chunks carved by
+ * a bump pointer that are only given back by EventPool::Reset ().  Call
+ * Reset () after Simulator::Destroy (), when no event is alive any more;
+ * Print () reports the counters.
+ */
+class EventPool
+{
+public:
+  struct FreeList
+  {
+    void *head;
+    bool registered;   // known to Reset ()
+  };
+
+  struct Stats
+  {
+    uint64_t allocations;
+    uint64_t reused;
+    uint64_t fresh;
+    uint64_t live;
+    uint64_t peakLive;
+    uint64_t arenaBytes;
+  };
+
+  static void SetArena (bool arena)
+  {
+    NS_ABORT_MSG_IF (GetStats ().allocations > 0, "EventPool::SetArena must be called before the first event");
+    Arena () = arena;
+  }
+
+  static void *Allocate (FreeList &list, size_t size)
+  {
+    Stats &stats = GetStats ();
+    ++stats.allocations;
+    if (++stats.live > stats.peakLive)
+      {
+        stats.peakLive = stats.live;
+      }
+    if (list.head != 0)
+      {
+        ++stats.reused;
+        void *block = list.head;
+        list.head = *static_cast<void **> (block);
+        return block;
+      }
+    ++stats.fresh;
+    if (!list.registered)
+      {
+        list.registered = true;
+        Lists ().push_back (&list);
+      }
+    return Arena () ? Bump (size) : ::operator new (size);
+  }
+
+  static void Release (FreeList &list, void *block)
+  {
+    --GetStats ().live;
+    *static_cast<void **> (block) = list.head;
+    list.head = block;
+  }
+
+  // Drops every free list and the arena; only valid once no event is alive
+  static void Reset ()
+  {
+    Stats &stats = GetStats ();
+    NS_ABORT_MSG_IF (stats.live > 0, "EventPool::Reset with " << stats.live << " live events");
+    std::vector<FreeList *> &lists = Lists ();
+    for (uint32_t i = 0; i < lists.size (); ++i)
+      {
+        while (!Arena () && lists[i]->head != 0)
+          {
+            void *block = lists[i]->head;
+            lists[i]->head = *static_cast<void **> (block);
+            ::operator delete (block);
+          }
+        lists[i]->head = 0;
+        lists[i]->registered = false;
+      }
+    lists.clear ();
+    std::vector<char *> &chunks = Chunks ();
+    for (uint32_t i = 0; i < chunks.size (); ++i)
+      {
+        delete [] chunks[i];
+      }
+    chunks.clear ();
+    Bumped () = CHUNK;
+  }
+
+  static void Print (std::ostream &os)
+  {
+    Stats &stats = GetStats ();
+    os << "Event pool: " << stats.allocations << " events, " << stats.reused << " from free lists, "
+       << stats.fresh << " fresh blocks, peak " << stats.peakLive << " live";
+    if (Arena ())
+      {
+        os << ", arena " << stats.arenaBytes << " bytes";
+      }
+    os << "\n";
+  }
+
+  static Stats &GetStats ()
+  {
+    static Stats stats = { 0, 0, 0, 0, 0, 0 };
+    return stats;
+  }
+
+private:
+  static const size_t CHUNK = 64 * 1024;
+  static const size_t ALIGN = 16;
+
+  static bool &Arena ()
+  {
+    static bool arena = false;
+    return arena;
+  }
+
+  static std::vector<FreeList *> &Lists ()
+  {
+    static std::vector<FreeList *> lists;
+    return lists;
+  }
+
+  static std::vector<char *> &Chunks ()
+  {
+    static std::vector<char *> chunks;
+    return chunks;
+  }
+
+  static size_t &Bumped ()
+  {
+    static size_t used = CHUNK;
+    return used;
+  }
+
+  static void *Bump (size_t size)
+  {
+    size = (size + ALIGN - 1) & ~(ALIGN - 1);
+    size_t &used = Bumped ();
+    if (used + size > CHUNK)
+      {
+        Chunks ().push_back (new char [CHUNK]);
+        GetStats ().arenaBytes += CHUNK;
+        used = 0;
+      }
+    void *block = Chunks ().back () + used;
+    used += size;
+    return block;
+  }
+};
+
+/// operator new/delete on a free list of T
+template <typename T>
+class PooledEventBase : public EventImpl
+{
+public:
+  static void *operator new (size_t size)
+  {
+    return EventPool::Allocate (List (), size);
+  }
+
+  static void operator delete (void *block)
+  {
+    EventPool::Release (List (), block);
+  }
+
+private:
+  static EventPool::FreeList &List ()
+  {
+    static EventPool::FreeList list = { 0, false };
+    return list;
+  }
+};
+
+template <typename F>
+class PooledFunctionEvent0 : public PooledEventBase<PooledFunctionEvent0<F> >
+{
+public:
+  PooledFunctionEvent0 (F f)
+    : m_f (f)
+  {
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    (*m_f)();
+  }
+
+  F m_f;
+};
+
+template <typename F, typename A1>
+class PooledFunctionEvent1 : public PooledEventBase<PooledFunctionEvent1<F, A1> >
+{
+public:
+  PooledFunctionEvent1 (F f, A1 a1)
+    : m_f (f),
+      m_a1 (a1)
+  {
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    (*m_f)(m_a1);
+  }
+
+  F m_f;
+  A1 m_a1;
+};
+
+template <typename F, typename A1, typename A2>
+class PooledFunctionEvent2 : public PooledEventBase<PooledFunctionEvent2<F, A1, A2> >
+{
+public:
+  PooledFunctionEvent2 (F f, A1 a1, A2 a2)
+    : m_f (f),
+      m_a1 (a1),
+      m_a2 (a2)
+  {
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    (*m_f)(m_a1, m_a2);
+  }
+
+  F m_f;
+  A1 m_a1;
+  A2 m_a2;
+};
+
+template <typename F, typename A1, typename A2, typename A3>
+class PooledFunctionEvent3 : public PooledEventBase<PooledFunctionEvent3<F, A1, A2, A3> >
+{
+public:
+  PooledFunctionEvent3 (F f, A1 a1, A2 a2, A3 a3)
+    : m_f (f),
+      m_a1 (a1),
+      m_a2 (a2),
+      m_a3 (a3)
+  {
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    (*m_f)(m_a1, m_a2, m_a3);
+  }
+
+  F m_f;
+  A1 m_a1;
+  A2 m_a2;
+  A3 m_a3;
+};
+
+template <typename F, typename A1, typename A2, typename A3, typename A4>
+class PooledFunctionEvent4 : public PooledEventBase<PooledFunctionEvent4<F, A1, A2, A3, A4> >
+{
+public:
+  PooledFunctionEvent4 (F f, A1 a1, A2 a2, A3 a3, A4 a4)
+    : m_f (f),
+      m_a1 (a1),
+      m_a2 (a2),
+      m_a3 (a3),
+      m_a4 (a4)
+  {
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    (*m_f)(m_a1, m_a2, m_a3, m_a4);
+  }
+
+  F m_f;
+  A1 m_a1;
+  A2 m_a2;
+  A3 m_a3;
+  A4 m_a4;
+};
+
+// A new EventImpl starts with one reference, which the Ptr adopts
+template <typename F>
+EventId PooledSchedule (Time const &delay, F f)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (new PooledFunctionEvent0<F> (f), false));
+}
+
+template <typename F, typename T1>
+EventId PooledSchedule (Time const &delay, F f, T1 a1)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (new PooledFunctionEvent1<F, T1> (f, a1), false));
+}
+
+template <typename F, typename T1, typename T2>
+EventId PooledSchedule (Time const &delay, F f, T1 a1, T2 a2)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (new PooledFunctionEvent2<F, T1, T2> (f, a1, a2), false));
+}
+
+template <typename F, typename T1, typename T2, typename T3>
+EventId PooledSchedule (Time const &delay, F f, T1 a1, T2 a2, T3 a3)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (new PooledFunctionEvent3<F, T1, T2, T3> (f, a1, a2, a3), false));
+}
+
+template <typename F, typename T1, typename T2, typename T3, typename T4>
+EventId PooledSchedule (Time const &delay, F f, T1 a1, T2 a2, T3 a3, T4 a4)
+{
+  return Simulator::Schedule (delay, Ptr<EventImpl> (new PooledFunctionEvent4<F, T1, T2, T3, T4> (f, a1, a2, a3, a4), false));
+}
+
+} // namespace ns3
+
+#endif /* EVENT_POOL_H */
@@ -0,0 +1,328 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef EVENT_SCHEDULER_H
+#define EVENT_SCHEDULER_H
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+
+namespace ns3 {
+
+/*
+ * Event scheduler selection for the scratch scenarios.  SelectScheduler ()
+ * maps a --scheduler name onto a scheduler type:
+ *   map       ns3::MapScheduler, the ns-3 default
+ *   heap      ns3::HeapScheduler
+ *   list      ns3::ListScheduler
+ *   calendar  ns3::CalendarScheduler
+ *   quadheap  QuadHeapScheduler below
+ * Given a trace file every Insert/RemoveNext/Remove is also recorded by
+ * RecordingScheduler, so the event-time distribution of a real run can be
+ * replayed against each scheduler by scheduler-bench.cc.
+ */
+
+/*
+ * Implicit 4-ary min-heap.  Against the binary HeapScheduler it halves the
+ * tree depth, and the four children of a node are adjacent in memory, so a
+ * sift-down touches about one cache line per level.  Events are moved into
+ * a hole instead of being swapped.
+ */
+class QuadHeapScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::QuadHeapScheduler")
+      .SetParent (Scheduler::GetTypeId ())
+      .AddConstructor<QuadHeapScheduler> ();
+    return tid;
+  }
+
+  virtual void Insert (const Scheduler::Event &ev)
+  {
+    m_heap.push_back (ev);
+    SiftUp (m_heap.size () - 1, ev);
+  }
+
+  virtual bool IsEmpty (void) const
+  {
+    return m_heap.empty ();
+  }
+
+  virtual Scheduler::Event PeekNext (void) const
+  {
+    NS_ASSERT (!m_heap.empty ());
+    return m_heap.front ();
+  }
+
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    NS_ASSERT (!m_heap.empty ());
+    Scheduler::Event next = m_heap.front ();
+    RemoveAt (0);
+    return next;
+  }
+
+  // Cancelled events are rare (Simulator::Remove only), a linear search is fine
+  virtual void Remove (const Scheduler::Event &ev)
+  {
+    for (uint32_t i = 0; i < m_heap.size (); ++i)
+      {
+        if (m_heap[i].key.m_uid == ev.key.m_uid)
+          {
+            NS_ASSERT (m_heap[i].impl == ev.impl);
+            RemoveAt (i);
+            return;
+          }
+      }
+    NS_ASSERT (false);
+  }
+
+private:
+  static const uint32_t ARITY = 4;
+
+  void RemoveAt (uint32_t i)
+  {
+    Scheduler::Event last = m_heap.back ();
+    m_heap.pop_back ();
+    if (i == m_heap.size ())
+      {
+        return;
+      }
+    if (i > 0 && last < m_heap[(i - 1) / ARITY])
+      {
+        SiftUp (i, last);
+      }
+    else
+      {
+        SiftDown (i, last);
+      }
+  }
+
+  // Place ev at hole i or above
+  void SiftUp (uint32_t i, const Scheduler::Event &ev)
+  {
+    while (i > 0)
+      {
+        uint32_t parent = (i - 1) / ARITY;
+        if (!(ev < m_heap[parent]))
+          {
+            break;
+          }
+        m_heap[i] = m_heap[parent];
+        i = parent;
+      }
+    m_heap[i] = ev;
+  }
+
+  // Place ev at hole i or below
+  void SiftDown (uint32_t i, const Scheduler::Event &ev)
+  {
+    uint32_t n = m_heap.size ();
+    while (true)
+      {
+        uint32_t first = i * ARITY + 1;
+        if (first >= n)
+          {
+            break;
+          }
+        uint32_t last = first + ARITY < n ? first + ARITY : n;
+        uint32_t min = first;
+        for (uint32_t c = first + 1; c < last; ++c)
+          {
+            if (m_heap[c] < m_heap[min])
+              {
+                min = c;
+              }
+          }
+        if (!(m_heap[min] < ev))
+          {
+            break;
+          }
+        m_heap[i] = m_heap[min];
+        i = min;
+      }
+    m_heap[i] = ev;
+  }
+
+  std::vector<Scheduler::Event> m_heap;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (QuadHeapScheduler);
+
+/// One scheduler operation as written by RecordingScheduler
+struct EventTraceRecord
+{
+  enum Op
+  {
+    INSERT, REMOVE_NEXT, REMOVE
+  };
+  uint64_t delay;   // event time minus the time of the last removed event
+  uint32_t uid;
+  uint32_t op;
+};
+
+/*
+ * Forwards to the scheduler chosen by SelectScheduler () and appends an
+ * EventTraceRecord per operation to the trace file.
+ */
+class RecordingScheduler : public Scheduler
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::RecordingScheduler")
+      .SetParent (Scheduler::GetTypeId ())
+      .AddConstructor<RecordingScheduler> ();
+    return tid;
+  }
+
+  RecordingScheduler ()
+    : m_now (0),
+      m_records (0)
+  {
+    ObjectFactory factory;
+    factory.SetTypeId (InnerType ());
+    m_inner = factory.Create<Scheduler> ();
+    m_file = std::fopen (TraceFile ().c_str (), "wb");
+    NS_ABORT_MSG_IF (m_file == 0, "Cannot open scheduler trace " << TraceFile ());
+    std::setvbuf (m_file, 0, _IOFBF, 1 << 16);
+  }
+
+  ~RecordingScheduler ()
+  {
+    std::fclose (m_file);
+    std::cout << "Scheduler trace: " << m_records << " operations written to " << TraceFile () << "\n";
+  }
+
+  static std::string &InnerType ()
+  {
+    static std::string type ("ns3::MapScheduler");
+    return type;
+  }
+
+  static std::string &TraceFile ()
+  {
+    static std::string file;
+    return file;
+  }
+
+  virtual void Insert (const Scheduler::Event &ev)
+  {
+    Write (EventTraceRecord::INSERT, ev);
+    m_inner->Insert (ev);
+  }
+
+  virtual bool IsEmpty (void) const
+  {
+    return m_inner->IsEmpty ();
+  }
+
+  virtual Scheduler::Event PeekNext (void) const
+  {
+    return m_inner->PeekNext ();
+  }
+
+  virtual Scheduler::Event RemoveNext (void)
+  {
+    Scheduler::Event next = m_inner->RemoveNext ();
+    Write (EventTraceRecord::REMOVE_NEXT, next);
+    m_now = next.key.m_ts;
+    return next;
+  }
+
+  virtual void Remove (const Scheduler::Event &ev)
+  {
+    Write (EventTraceRecord::REMOVE, ev);
+    m_inner->Remove (ev);
+  }
+
+private:
+  void Write (uint32_t op, const Scheduler::Event &ev)
+  {
+    EventTraceRecord r;
+    r.delay = ev.key.m_ts - m_now;
+    r.uid = ev.key.m_uid;
+    r.op = op;
+    std::fwrite (&r, sizeof (r), 1, m_file);
+    ++m_records;
+  }
+
+  Ptr<Scheduler> m_inner;
+  FILE *m_file;
+  uint64_t m_now;
+  uint64_t m_records;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (RecordingScheduler);
+
+/// --scheduler name -> TypeId name, empty when unknown
+inline std::string
+SchedulerTypeName (std::string name)
+{
+  if (name == "map")
+    {
+      return "ns3::MapScheduler";
+    }
+  if (name == "heap")
+    {
+      return "ns3::HeapScheduler";
+    }
+  if (name == "list")
+    {
+      return "ns3::ListScheduler";
+    }
+  if (name == "calendar")
+    {
+      return "ns3::CalendarScheduler";
+    }
+  if (name == "quadheap")
+    {
+      return "ns3::QuadHeapScheduler";
+    }
+  return "";
+}
+
+/// Call before anything is scheduled; returns false for an unknown name
+inline bool
+SelectScheduler (std::string name, std::string traceFile)
+{
+  std::string type = SchedulerTypeName (name);
+  if (type.empty ())
+    {
+      return false;
+    }
+  ObjectFactory factory;
+  if (traceFile.empty ())
+    {
+      factory.SetTypeId (type);
+    }
+  else
+    {
+      RecordingScheduler::InnerType () = type;
+      RecordingScheduler::TraceFile () = traceFile;
+      factory.SetTypeId ("ns3::RecordingScheduler");
+    }
+  Simulator::SetScheduler (factory);
+  return true;
+}
+
+} // namespace ns3
+
+#endif /* EVENT_SCHEDULER_H */
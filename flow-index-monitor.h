@@ -0,0 +1,195 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef FLOW_INDEX_MONITOR_H
+#define FLOW_INDEX_MONITOR_H
+
+#include <iostream>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+
+namespace ns3 {
+
+/*
+ * Flow index and send time, stamped on each packet by the sending
+ * application.  12 bytes as a byte tag, so it survives fragmentation and
+ * every hop like the FlowMonitor probe tag.
+ */
+class FlowIndexTag : public Tag
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::FlowIndexTag")
+      .SetParent<Tag> ()
+      .AddConstructor<FlowIndexTag> ();
+    return tid;
+  }
+
+  FlowIndexTag ()
+    : m_flow (0),
+      m_txTime (0)
+  {
+  }
+
+  FlowIndexTag (uint32_t flow, int64_t txTime)
+    : m_flow (flow),
+      m_txTime (txTime)
+  {
+  }
+
+  virtual TypeId GetInstanceTypeId (void) const
+  {
+    return GetTypeId ();
+  }
+
+  virtual uint32_t GetSerializedSize (void) const
+  {
+    return 12;
+  }
+
+  virtual void Serialize (TagBuffer buf) const
+  {
+    buf.WriteU32 (m_flow);
+    buf.WriteU64 (m_txTime);
+  }
+
+  virtual void Deserialize (TagBuffer buf)
+  {
+    m_flow = buf.ReadU32 ();
+    m_txTime = buf.ReadU64 ();
+  }
+
+  virtual void Print (std::ostream &os) const
+  {
+    os << "flow=" << m_flow << " txTime=" << m_txTime;
+  }
+
+  uint32_t m_flow;
+  int64_t m_txTime;   // time steps
+};
+
+NS_OBJECT_ENSURE_REGISTERED (FlowIndexTag);
+
+/*
+ * Lightweight alternative to FlowMonitor + Ipv4FlowClassifier.  Flows are
+ * declared up front by AddFlow (app), which stamps every packet the
+ * application sends with a FlowIndexTag.  Install () hooks the IPv4
+ * SendOutgoing, UnicastForward and LocalDeliver traces, which read only the
+ * tag and update a flat counter vector indexed by it: no 5-tuple parsing
+ * and no map lookup per hop.  Untagged packets (routing, ARP workarounds)
+ * are ignored.  Byte counts include the IPv4 header, as in FlowMonitor.
+ */
+class FlowIndexMonitor
+{
+public:
+  struct FlowCounters
+  {
+    uint64_t txPackets;
+    uint64_t txBytes;
+    uint64_t rxPackets;
+    uint64_t rxBytes;
+    uint64_t forwarded;   // hops after the first
+    int64_t delaySum;     // time steps, application send to local delivery
+  };
+
+  // Returns the flow index of the application's packets
+  uint32_t AddFlow (Ptr<Application> app)
+  {
+    uint32_t flow = m_flows.size ();
+    FlowCounters zero = { 0, 0, 0, 0, 0, 0 };
+    m_flows.push_back (zero);
+    app->TraceConnectWithoutContext ("Tx", MakeBoundCallback (&FlowIndexMonitor::Stamp, flow));
+    return flow;
+  }
+
+  void Install (NodeContainer nodes)
+  {
+    for (uint32_t i = 0; i < nodes.GetN (); ++i)
+      {
+        Ptr<Ipv4L3Protocol> ipv4 = nodes.Get (i)->GetObject<Ipv4L3Protocol> ();
+        ipv4->TraceConnectWithoutContext ("SendOutgoing", MakeCallback (&FlowIndexMonitor::SendOutgoing, this));
+        ipv4->TraceConnectWithoutContext ("UnicastForward", MakeCallback (&FlowIndexMonitor::Forward, this));
+        ipv4->TraceConnectWithoutContext ("LocalDeliver", MakeCallback (&FlowIndexMonitor::LocalDeliver, this));
+      }
+  }
+
+  uint32_t GetNFlows () const
+  {
+    return m_flows.size ();
+  }
+
+  const FlowCounters &Get (uint32_t flow) const
+  {
+    return m_flows[flow];
+  }
+
+private:
+  static void Stamp (uint32_t flow, Ptr<const Packet> p)
+  {
+    p->AddByteTag (FlowIndexTag (flow, Simulator::Now ().GetTimeStep ()));
+  }
+
+  FlowCounters *Find (Ptr<const Packet> p, FlowIndexTag &tag)
+  {
+    if (!p->FindFirstMatchingByteTag (tag) || tag.m_flow >= m_flows.size ())
+      {
+        return 0;
+      }
+    return &m_flows[tag.m_flow];
+  }
+
+  void SendOutgoing (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+  {
+    FlowIndexTag tag;
+    FlowCounters *c = Find (p, tag);
+    if (c != 0)
+      {
+        ++c->txPackets;
+        c->txBytes += p->GetSize () + header.GetSerializedSize ();
+      }
+  }
+
+  void Forward (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+  {
+    FlowIndexTag tag;
+    FlowCounters *c = Find (p, tag);
+    if (c != 0)
+      {
+        ++c->forwarded;
+      }
+  }
+
+  void LocalDeliver (const Ipv4Header &header, Ptr<const Packet> p, uint32_t interface)
+  {
+    FlowIndexTag tag;
+    FlowCounters *c = Find (p, tag);
+    if (c != 0)
+      {
+        ++c->rxPackets;
+        c->rxBytes += p->GetSize () + header.GetSerializedSize ();
+        c->delaySum += Simulator::Now ().GetTimeStep () - tag.m_txTime;
+      }
+  }
+
+  std::vector<FlowCounters> m_flows;
+};
+
+} // namespace ns3
+
+#endif /* FLOW_INDEX_MONITOR_H */
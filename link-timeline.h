@@ -0,0 +1,584 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef LINK_TIMELINE_H
+#define LINK_TIMELINE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+namespace ns3 {
+
+/*
+ * Connectivity of a RangePropagationLossModel scenario is a pure function of
+ * the node trajectories.  LinkTimeline reads an ns-2 mobility trace (the same
+ * file Ns2MobilityHelper replays), turns it into piecewise-linear
+ * trajectories and solves, for every node pair, the exact time intervals
+ * during which the pair is within range.  Each node keeps its intervals twice:
+ * grouped by peer for IsUp () and sorted by start with subtree max-end values
+ * (an implicit interval tree) for Neighbors ().
+ */
+class LinkTimeline
+{
+public:
+  struct Interval
+  {
+    uint32_t peer;
+    double start;
+    double end;
+  };
+
+  LinkTimeline ()
+    : m_range (0),
+      m_stopTime (0)
+  {
+  }
+
+  bool IsBuilt () const
+  {
+    return !m_byStart.empty ();
+  }
+
+  void Build (std::string traceFile, uint32_t nNodes, double range, double stopTime)
+  {
+    m_range = range;
+    m_stopTime = stopTime;
+    std::vector<std::vector<Segment> > paths;
+    ReadNs2Trace (traceFile, nNodes, paths);
+
+    std::vector<std::vector<Interval> > byNode (nNodes);
+    for (uint32_t a = 0; a < nNodes; ++a)
+      {
+        for (uint32_t b = a + 1; b < nNodes; ++b)
+          {
+            std::vector<std::pair<double, double> > up;
+            SolvePair (paths[a], paths[b], up);
+            for (uint32_t k = 0; k < up.size (); ++k)
+              {
+                Interval ab = { b, up[k].first, up[k].second };
+                Interval ba = { a, up[k].first, up[k].second };
+                byNode[a].push_back (ab);
+                byNode[b].push_back (ba);
+              }
+          }
+      }
+
+    m_byPeer = byNode;
+    m_byStart = byNode;
+    m_maxEnd.assign (nNodes, std::vector<double> ());
+    for (uint32_t n = 0; n < nNodes; ++n)
+      {
+        std::sort (m_byPeer[n].begin (), m_byPeer[n].end (), ByPeer);
+        std::sort (m_byStart[n].begin (), m_byStart[n].end (), ByStart);
+        m_maxEnd[n].resize (m_byStart[n].size ());
+        if (!m_byStart[n].empty ())
+          {
+            BuildMaxEnd (n, 0, m_byStart[n].size () - 1);
+          }
+      }
+  }
+
+  // O(log degree + log intervals of the pair)
+  bool IsUp (uint32_t a, uint32_t b, double t) const
+  {
+    const std::vector<Interval> &links = m_byPeer[a];
+    Interval key = { b, t, t };
+    std::vector<Interval>::const_iterator it = std::upper_bound (links.begin (), links.end (), key, ByPeer);
+    return it != links.begin () && (--it)->peer == b && it->end >= t;
+  }
+
+  // Stabbing query on the node's interval tree
+  void Neighbors (uint32_t node, double t, std::vector<uint32_t> &peers) const
+  {
+    peers.clear ();
+    if (!m_byStart[node].empty ())
+      {
+        Stab (node, 0, m_byStart[node].size () - 1, t, peers);
+      }
+  }
+
+  // Per-link CSV (a,b,start,end,duration) and partition CSV (start,end,components)
+  void WriteStats (std::string prefix) const
+  {
+    std::ofstream links ((prefix + "-links.csv").c_str ());
+    links << "a,b,start,end,duration\n";
+    for (uint32_t a = 0; a < m_byPeer.size (); ++a)
+      {
+        for (uint32_t k = 0; k < m_byPeer[a].size (); ++k)
+          {
+            const Interval &i = m_byPeer[a][k];
+            if (i.peer > a)
+              {
+                links << a << "," << i.peer << "," << i.start << "," << i.end << "," << i.end - i.start << "\n";
+              }
+          }
+      }
+
+    std::ofstream partitions ((prefix + "-partitions.csv").c_str ());
+    partitions << "start,end,components\n";
+    std::vector<Epoch> epochs;
+    Components (epochs);
+    for (uint32_t k = 0; k < epochs.size (); ++k)
+      {
+        if (epochs[k].components > 1)
+          {
+            partitions << epochs[k].start << "," << epochs[k].end << "," << epochs[k].components << "\n";
+          }
+      }
+  }
+
+  void Report (std::ostream &os) const
+  {
+    uint64_t count = 0;
+    double total = 0;
+    double longest = 0;
+    for (uint32_t a = 0; a < m_byPeer.size (); ++a)
+      {
+        for (uint32_t k = 0; k < m_byPeer[a].size (); ++k)
+          {
+            const Interval &i = m_byPeer[a][k];
+            if (i.peer > a)
+              {
+                ++count;
+                total += i.end - i.start;
+                longest = std::max (longest, i.end - i.start);
+              }
+          }
+      }
+    std::vector<Epoch> epochs;
+    Components (epochs);
+    double partitioned = 0;
+    uint32_t episodes = 0;
+    double componentTime = 0;
+    for (uint32_t k = 0; k < epochs.size (); ++k)
+      {
+        double len = epochs[k].end - epochs[k].start;
+        componentTime += len * epochs[k].components;
+        if (epochs[k].components > 1)
+          {
+            partitioned += len;
+            if (k == 0 || epochs[k - 1].components == 1)
+              {
+                ++episodes;
+              }
+          }
+      }
+    os << "Link timeline: " << count << " links, mean duration "
+       << (count ? total / count : 0) << " s, longest " << longest << " s\n";
+    os << "Link timeline: partitioned " << partitioned << " of " << m_stopTime << " s in "
+       << episodes << " episodes, mean components " << (m_stopTime > 0 ? componentTime / m_stopTime : 0) << "\n";
+  }
+
+private:
+  struct Segment
+  {
+    double t;           // segment start; valid until the next segment
+    double x, y, z;     // position at t
+    double vx, vy, vz;  // velocity
+  };
+
+  struct Epoch
+  {
+    double start;
+    double end;
+    uint32_t components;
+  };
+
+  static bool ByPeer (const Interval &l, const Interval &r)
+  {
+    return l.peer < r.peer || (l.peer == r.peer && l.start < r.start);
+  }
+
+  static bool ByStart (const Interval &l, const Interval &r)
+  {
+    return l.start < r.start;
+  }
+
+  double BuildMaxEnd (uint32_t n, uint32_t lo, uint32_t hi)
+  {
+    uint32_t mid = lo + (hi - lo) / 2;
+    double maxEnd = m_byStart[n][mid].end;
+    if (mid > lo)
+      {
+        maxEnd = std::max (maxEnd, BuildMaxEnd (n, lo, mid - 1));
+      }
+    if (mid < hi)
+      {
+        maxEnd = std::max (maxEnd, BuildMaxEnd (n, mid + 1, hi));
+      }
+    m_maxEnd[n][mid] = maxEnd;
+    return maxEnd;
+  }
+
+  void Stab (uint32_t n, uint32_t lo, uint32_t hi, double t, std::vector<uint32_t> &peers) const
+  {
+    uint32_t mid = lo + (hi - lo) / 2;
+    if (m_maxEnd[n][mid] < t)
+      {
+        return;
+      }
+    if (mid > lo)
+      {
+        Stab (n, lo, mid - 1, t, peers);
+      }
+    const Interval &i = m_byStart[n][mid];
+    if (i.start <= t)
+      {
+        if (i.end >= t)
+          {
+            peers.push_back (i.peer);
+          }
+        if (mid < hi)
+          {
+            Stab (n, mid + 1, hi, t, peers);
+          }
+      }
+  }
+
+  // Supports "$node_(i) set X_|Y_|Z_ v" and
+  // "$ns_ at t "$node_(i) setdest x y speed"", with Ns2MobilityHelper semantics:
+  // a node moves in a straight line to the destination and stops there.
+  void ReadNs2Trace (std::string traceFile, uint32_t nNodes, std::vector<std::vector<Segment> > &paths) const
+  {
+    std::ifstream in (traceFile.c_str ());
+    NS_ABORT_MSG_IF (!in.is_open (), "Cannot open mobility trace " << traceFile);
+    paths.assign (nNodes, std::vector<Segment> ());
+    std::vector<Segment> state (nNodes);
+    std::vector<double> arrival (nNodes, std::numeric_limits<double>::infinity ());
+    for (uint32_t n = 0; n < nNodes; ++n)
+      {
+        Segment s = { 0, 0, 0, 0, 0, 0, 0 };
+        state[n] = s;
+      }
+
+    std::string line;
+    while (std::getline (in, line))
+      {
+        std::string::size_type node = line.find ("$node_(");
+        if (node == std::string::npos)
+          {
+            continue;
+          }
+        uint32_t id = std::atoi (line.c_str () + node + 7);
+        if (id >= nNodes)
+          {
+            continue;
+          }
+        double t = 0;
+        std::string::size_type at = line.find ("$ns_ at ");
+        if (at != std::string::npos)
+          {
+            t = std::atof (line.c_str () + at + 8);
+          }
+        Segment &s = state[id];
+        if (arrival[id] <= t)
+          {
+            Stop (paths[id], s, arrival[id]);
+            arrival[id] = std::numeric_limits<double>::infinity ();
+          }
+        Advance (s, t);
+
+        std::string::size_type cmd;
+        if ((cmd = line.find ("setdest")) != std::string::npos)
+          {
+            std::istringstream args (line.substr (cmd + 7));
+            double x, y, speed;
+            args >> x >> y >> speed;
+            double dx = x - s.x;
+            double dy = y - s.y;
+            double dist = std::sqrt (dx * dx + dy * dy);
+            if (speed <= 0 || dist == 0)
+              {
+                s.vx = s.vy = s.vz = 0;
+              }
+            else
+              {
+                s.vx = dx / dist * speed;
+                s.vy = dy / dist * speed;
+                s.vz = 0;
+                arrival[id] = t + dist / speed;
+              }
+          }
+        else if ((cmd = line.find ("set ")) != std::string::npos && cmd + 6 < line.size ())
+          {
+            char axis = line[cmd + 4];
+            double v = std::atof (line.c_str () + cmd + 7);
+            (axis == 'X' ? s.x : axis == 'Y' ? s.y : s.z) = v;
+            s.vx = s.vy = s.vz = 0;
+          }
+        else
+          {
+            continue;
+          }
+        s.t = t;
+        if (!paths[id].empty () && paths[id].back ().t == t)
+          {
+            paths[id].back () = s;
+          }
+        else
+          {
+            paths[id].push_back (s);
+          }
+      }
+    for (uint32_t n = 0; n < nNodes; ++n)
+      {
+        if (arrival[n] < std::numeric_limits<double>::infinity ())
+          {
+            Stop (paths[n], state[n], arrival[n]);
+          }
+        if (paths[n].empty () || paths[n].front ().t > 0)
+          {
+            Segment s = paths[n].empty () ? state[n] : paths[n].front ();
+            s.t = 0;
+            s.vx = s.vy = s.vz = 0;
+            paths[n].insert (paths[n].begin (), s);
+          }
+      }
+  }
+
+  static void Advance (Segment &s, double t)
+  {
+    double dt = t - s.t;
+    s.x += s.vx * dt;
+    s.y += s.vy * dt;
+    s.z += s.vz * dt;
+    s.t = t;
+  }
+
+  static void Stop (std::vector<Segment> &path, Segment &s, double t)
+  {
+    Advance (s, t);
+    s.vx = s.vy = s.vz = 0;
+    path.push_back (s);
+  }
+
+  // Within one piece the relative motion is linear, so |dp + dv s| <= range
+  // is a quadratic inequality in s with at most one solution interval.
+  void SolvePair (const std::vector<Segment> &a, const std::vector<Segment> &b,
+                  std::vector<std::pair<double, double> > &up) const
+  {
+    uint32_t i = 0;
+    uint32_t j = 0;
+    double t = 0;
+    double r2 = m_range * m_range;
+    while (t < m_stopTime)
+      {
+        while (i + 1 < a.size () && a[i + 1].t <= t)
+          {
+            ++i;
+          }
+        while (j + 1 < b.size () && b[j + 1].t <= t)
+          {
+            ++j;
+          }
+        double next = m_stopTime;
+        if (i + 1 < a.size ())
+          {
+            next = std::min (next, a[i + 1].t);
+          }
+        if (j + 1 < b.size ())
+          {
+            next = std::min (next, b[j + 1].t);
+          }
+
+        Segment sa = a[i];
+        Segment sb = b[j];
+        Advance (sa, t);
+        Advance (sb, t);
+        double px = sa.x - sb.x, py = sa.y - sb.y, pz = sa.z - sb.z;
+        double vx = sa.vx - sb.vx, vy = sa.vy - sb.vy, vz = sa.vz - sb.vz;
+        double qa = vx * vx + vy * vy + vz * vz;
+        double qb = 2 * (px * vx + py * vy + pz * vz);
+        double qc = px * px + py * py + pz * pz - r2;
+        double len = next - t;
+        double lo = 1;
+        double hi = 0;
+        if (qa == 0)
+          {
+            if (qc <= 0)
+              {
+                lo = 0;
+                hi = len;
+              }
+          }
+        else
+          {
+            double disc = qb * qb - 4 * qa * qc;
+            if (disc >= 0)
+              {
+                double root = std::sqrt (disc);
+                lo = std::max (0.0, (-qb - root) / (2 * qa));
+                hi = std::min (len, (-qb + root) / (2 * qa));
+              }
+          }
+        if (lo <= hi)
+          {
+            if (!up.empty () && up.back ().second >= t + lo - 1e-9)
+              {
+                up.back ().second = t + hi;
+              }
+            else
+              {
+                up.push_back (std::make_pair (t + lo, t + hi));
+              }
+          }
+        t = next;
+      }
+  }
+
+  // Connected components between consecutive link events, by union-find
+  // over the links active in each epoch.
+  void Components (std::vector<Epoch> &epochs) const
+  {
+    std::vector<double> events;
+    for (uint32_t a = 0; a < m_byPeer.size (); ++a)
+      {
+        for (uint32_t k = 0; k < m_byPeer[a].size (); ++k)
+          {
+            if (m_byPeer[a][k].peer > a)
+              {
+                events.push_back (m_byPeer[a][k].start);
+                events.push_back (m_byPeer[a][k].end);
+              }
+          }
+      }
+    events.push_back (0.0);
+    events.push_back (m_stopTime);
+    std::sort (events.begin (), events.end ());
+
+    uint32_t nNodes = m_byPeer.size ();
+    std::vector<uint32_t> parent (nNodes);
+    std::vector<uint32_t> peers;
+    epochs.clear ();
+    for (uint32_t e = 0; e + 1 < events.size (); ++e)
+      {
+        double start = events[e];
+        double end = events[e + 1];
+        if (end <= start || start >= m_stopTime)
+          {
+            continue;
+          }
+        double mid = (start + end) / 2;
+        for (uint32_t n = 0; n < nNodes; ++n)
+          {
+            parent[n] = n;
+          }
+        uint32_t components = nNodes;
+        for (uint32_t n = 0; n < nNodes; ++n)
+          {
+            Neighbors (n, mid, peers);
+            for (uint32_t k = 0; k < peers.size (); ++k)
+              {
+                uint32_t ra = Find (parent, n);
+                uint32_t rb = Find (parent, peers[k]);
+                if (ra != rb)
+                  {
+                    parent[ra] = rb;
+                    --components;
+                  }
+              }
+          }
+        if (!epochs.empty () && epochs.back ().components == components)
+          {
+            epochs.back ().end = end;
+          }
+        else
+          {
+            Epoch epoch = { start, end, components };
+            epochs.push_back (epoch);
+          }
+      }
+  }
+
+  static uint32_t Find (std::vector<uint32_t> &parent, uint32_t n)
+  {
+    while (parent[n] != n)
+      {
+        parent[n] = parent[parent[n]];
+        n = parent[n];
+      }
+    return n;
+  }
+
+  double m_range;
+  double m_stopTime;
+  std::vector<std::vector<Interval> > m_byPeer;   // per node, sorted by (peer, start)
+  std::vector<std::vector<Interval> > m_byStart;  // per node, sorted by start
+  std::vector<std::vector<double> > m_maxEnd;     // implicit interval tree over m_byStart
+};
+
+/*
+ * Drop-in replacement for RangePropagationLossModel that answers from a
+ * LinkTimeline instead of computing the distance for every frame.
+ */
+class LinkTimelineLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::LinkTimelineLossModel")
+      .SetParent (PropagationLossModel::GetTypeId ())
+      .AddConstructor<LinkTimelineLossModel> ();
+    return tid;
+  }
+
+  LinkTimelineLossModel ()
+    : m_timeline (0)
+  {
+  }
+
+  void SetTimeline (const LinkTimeline *timeline)
+  {
+    m_timeline = timeline;
+  }
+
+private:
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    uint32_t ia = a->GetObject<Node> ()->GetId ();
+    uint32_t ib = b->GetObject<Node> ()->GetId ();
+    if (m_timeline->IsUp (ia, ib, Simulator::Now ().GetSeconds ()))
+      {
+        return txPowerDbm;
+      }
+    return -1000;
+  }
+
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+
+  const LinkTimeline *m_timeline;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (LinkTimelineLossModel);
+
+} // namespace ns3
+
+#endif /* LINK_TIMELINE_H */
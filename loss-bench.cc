@@ -0,0 +1,191 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Propagation loss benchmark: BatchedLossModel (batched-loss-model.h)
+ * against the scalar ns-3 Friis and log-distance models.
+ *
+ *   kernel   --count squared distances, log-uniform from 1 cm to 100 km,
+ *            through ComputeLoss () and through the double precision
+ *            formula one at a time, in million losses per second
+ *   channel  every ordered pair of --nodes nodes placed at random in a
+ *            --side metre square, asked sender by sender through
+ *            CalcRxPower () as YansWifiChannel does, for the ns-3 model
+ *            and for BatchedLossModel
+ *
+ * Each row gives the largest difference in dB between the two; the last
+ * column says whether it stays within 0.001 dB.
+ *
+ * ./waf --run "loss-bench --count=1048576 --nodes=500"
+ */
+
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+#include "batched-loss-model.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+static const double TOLERANCE_DB = 0.001;
+
+static double
+Uniform ()
+{
+  return std::rand () / (RAND_MAX + 1.0);
+}
+
+static void
+Print (std::string name, std::string test, double scalarMps, double batchedMps, double maxErr)
+{
+  std::cout << std::left << std::setw (8) << name << std::setw (9) << test << std::right
+            << std::fixed << std::setprecision (2)
+            << std::setw (10) << scalarMps << std::setw (11) << batchedMps
+            << std::setprecision (6) << std::setw (12) << maxErr
+            << "  " << (maxErr <= TOLERANCE_DB ? "yes" : "NO") << "\n";
+}
+
+// ComputeLoss () against ReferenceLoss () over the same distances
+static void
+Kernel (std::string name, const BatchedLossModel &model, const std::vector<float> &d2, uint32_t repeat)
+{
+  uint32_t n = d2.size ();
+  std::vector<float> loss (n);
+  double start = WallClock ();
+  for (uint32_t r = 0; r < repeat; ++r)
+    {
+      model.ComputeLoss (&d2[0], n, &loss[0]);
+    }
+  double batched = WallClock () - start;
+
+  std::vector<double> reference (n);
+  start = WallClock ();
+  for (uint32_t r = 0; r < repeat; ++r)
+    {
+      for (uint32_t i = 0; i < n; ++i)
+        {
+          reference[i] = model.ReferenceLoss (d2[i]);
+        }
+    }
+  double scalar = WallClock () - start;
+
+  double maxErr = 0;
+  for (uint32_t i = 0; i < n; ++i)
+    {
+      maxErr = std::max (maxErr, std::fabs (loss[i] - reference[i]));
+    }
+  double total = double (n) * repeat / 1e6;
+  Print (name, "kernel", total / scalar, total / batched, maxErr);
+}
+
+// All ordered pairs of nodes, sender by sender, through CalcRxPower ()
+static void
+Channel (std::string name, Ptr<PropagationLossModel> scalar, Ptr<BatchedLossModel> batched,
+         const std::vector<Ptr<MobilityModel> > &mobility)
+{
+  uint32_t n = mobility.size ();
+  std::vector<double> rx (n * n);
+  double start = WallClock ();
+  for (uint32_t s = 0; s < n; ++s)
+    {
+      for (uint32_t r = 0; r < n; ++r)
+        {
+          if (r != s)
+            {
+              rx[s * n + r] = scalar->CalcRxPower (0, mobility[s], mobility[r]);
+            }
+        }
+    }
+  double scalarTime = WallClock () - start;
+
+  double maxErr = 0;
+  start = WallClock ();
+  for (uint32_t s = 0; s < n; ++s)
+    {
+      for (uint32_t r = 0; r < n; ++r)
+        {
+          if (r != s)
+            {
+              double b = batched->CalcRxPower (0, mobility[s], mobility[r]);
+              maxErr = std::max (maxErr, std::fabs (b - rx[s * n + r]));
+            }
+        }
+    }
+  double batchedTime = WallClock () - start;
+
+  double total = double (n) * (n - 1) / 1e6;
+  Print (name, "channel", total / scalarTime, total / batchedTime, maxErr);
+}
+
+int main (int argc, char **argv)
+{
+  uint32_t count = 1 << 20;
+  uint32_t repeat = 10;
+  uint32_t nodes = 500;
+  double side = 3000;
+  double exponent = 3;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("count", "Distances per kernel pass", count);
+  cmd.AddValue ("repeat", "Kernel passes per model", repeat);
+  cmd.AddValue ("nodes", "Nodes on the channel", nodes);
+  cmd.AddValue ("side", "Side of the square the nodes are placed in (m)", side);
+  cmd.AddValue ("exponent", "Log-distance path loss exponent", exponent);
+  cmd.AddValue ("seed", "Random seed", seed);
+  cmd.Parse (argc, argv);
+
+  std::srand (seed);
+  std::vector<float> d2 (count);
+  for (uint32_t i = 0; i < count; ++i)
+    {
+      double d = 0.01 * std::pow (1e7, Uniform ());   // 1 cm to 100 km
+      d2[i] = d * d;
+    }
+
+  // nodes first: the batched models size their tables from the NodeList
+  NodeContainer c;
+  c.Create (nodes);
+  std::vector<Ptr<MobilityModel> > mobility;
+  for (uint32_t i = 0; i < nodes; ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> m = CreateObject<ConstantPositionMobilityModel> ();
+      m->SetPosition (Vector (Uniform () * side, Uniform () * side, 0));
+      c.Get (i)->AggregateObject (m);
+      mobility.push_back (m);
+    }
+
+  Ptr<FriisPropagationLossModel> friis = CreateObject<FriisPropagationLossModel> ();
+  Ptr<BatchedLossModel> batchedFriis = CreateObject<BatchedLossModel> ();
+  Ptr<LogDistancePropagationLossModel> logDistance = CreateObject<LogDistancePropagationLossModel> ();
+  logDistance->SetPathLossExponent (exponent);
+  Ptr<BatchedLossModel> batchedLogDistance = CreateObject<BatchedLossModel> ();
+  batchedLogDistance->SetLogDistance (exponent, 1, 46.6777);
+
+  std::cout << "model   test     scalar/M  batched/M    max err dB  match\n";
+  Kernel ("friis", *batchedFriis, d2, repeat);
+  Kernel ("logdist", *batchedLogDistance, d2, repeat);
+  Channel ("friis", friis, batchedFriis, mobility);
+  Channel ("logdist", logDistance, batchedLogDistance, mobility);
+  return 0;
+}
@@ -0,0 +1,299 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef MEMORY_REPORT_H
+#define MEMORY_REPORT_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/wifi-module.h"
+
+namespace ns3 {
+
+/*
+ * Approximate memory held per node and per layer, enabled with
+ * --memReport.  A snapshot is taken at each of the --memTimes (simulated
+ * seconds, e.g. "100,500") and by Finish () at the end of the run, before
+ * Simulator::Destroy () tears the nodes down.  Per node it adds up
+ *   node       the Node and its application objects
+ *   wifi-phy   YansWifiPhy objects
+ *   wifi-mac   the MAC and its DcaTxop
+ *   mac-queue  packets waiting in the DcaTxop queue
+ *   ipv4       Ipv4L3Protocol and its interfaces
+ *   arp        ARP cache entries
+ *   routing    routing table entries
+ * from object sizes, entry counts and queued packet sizes.  Entry counts
+ * come from the Print functions of the ARP caches and routing protocols,
+ * so they are line counts and only as exact as those printouts; entry
+ * sizes are estimates.  Report () prints the per-layer totals, the
+ * heaviest nodes and the process RSS of each snapshot, and writes every
+ * node of every snapshot to the --memFile JSON file.
+ */
+class MemoryReport
+{
+public:
+  enum Layer
+  {
+    NODE, WIFI_PHY, WIFI_MAC, MAC_QUEUE, IPV4, ARP, ROUTING, LAYERS
+  };
+
+  MemoryReport ()
+    : m_enabled (false),
+      m_fileName ("memory.json")
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("memReport", "Report approximate memory per node and layer, Default:false", m_enabled);
+    cmd.AddValue ("memTimes", "Memory snapshot times in seconds, e.g. 100,500 (the end of the run is always taken)", m_times);
+    cmd.AddValue ("memFile", "Memory report JSON file", m_fileName);
+  }
+
+  // Call before Simulator::Run ()
+  void Install ()
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    std::istringstream in (m_times);
+    std::string item;
+    while (std::getline (in, item, ','))
+      {
+        if (!item.empty ())
+          {
+            Simulator::Schedule (Seconds (std::atof (item.c_str ())), &MemoryReport::Snapshot, this);
+          }
+      }
+  }
+
+  // Call after Simulator::Run () and before Simulator::Destroy ()
+  void Finish ()
+  {
+    if (m_enabled)
+      {
+        Snapshot ();
+      }
+  }
+
+  void Report (std::ostream &os)
+  {
+    if (m_snapshots.empty ())
+      {
+        return;
+      }
+    for (uint32_t s = 0; s < m_snapshots.size (); ++s)
+      {
+        PrintTable (os, m_snapshots[s]);
+      }
+    WriteJson ();
+    os << "Memory report written to " << m_fileName << "\n";
+  }
+
+private:
+  struct Sample
+  {
+    double time;
+    uint64_t rss;
+    std::vector<std::vector<uint64_t> > nodes;   // [node][layer]
+  };
+
+  static const char *LayerName (uint32_t layer)
+  {
+    const char *names[] = { "node", "wifi-phy", "wifi-mac", "mac-queue", "ipv4", "arp", "routing" };
+    return names[layer];
+  }
+
+  // Estimates for entries whose type is private to their module
+  static const uint32_t ARP_ENTRY = 160;       // ArpCache::Entry, its map node and pending queue
+  static const uint32_t ROUTE_ENTRY = 192;     // routing table entry with map/list node
+  static const uint32_t PACKET_OVERHEAD = 160; // Packet, Buffer data header, metadata and queue item
+
+  void Snapshot ()
+  {
+    Sample snap;
+    snap.time = Simulator::Now ().GetSeconds ();
+    snap.rss = Rss ();
+    for (uint32_t n = 0; n < NodeList::GetNNodes (); ++n)
+      {
+        snap.nodes.push_back (Measure (NodeList::GetNode (n)));
+      }
+    m_snapshots.push_back (snap);
+  }
+
+  std::vector<uint64_t> Measure (Ptr<Node> node)
+  {
+    std::vector<uint64_t> bytes (LAYERS, 0);
+    bytes[NODE] = sizeof (Node) + node->GetNApplications () * sizeof (Application);
+    for (uint32_t d = 0; d < node->GetNDevices (); ++d)
+      {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (node->GetDevice (d));
+        if (device == 0)
+          {
+            bytes[NODE] += sizeof (NetDevice);
+            continue;
+          }
+        bytes[NODE] += sizeof (WifiNetDevice);
+        bytes[WIFI_PHY] += sizeof (YansWifiPhy);
+        bytes[WIFI_MAC] += sizeof (AdhocWifiMac) + sizeof (DcaTxop);
+        PointerValue ptr;
+        if (device->GetMac ()->GetAttributeFailSafe ("DcaTxop", ptr))
+          {
+            Ptr<WifiMacQueue> queue = ptr.Get<DcaTxop> ()->GetQueue ();
+            WifiMacHeader header;
+            Ptr<const Packet> front = queue->Peek (&header);
+            if (front != 0)
+              {
+                bytes[MAC_QUEUE] += queue->GetSize () * (front->GetSize () + sizeof (WifiMacHeader) + PACKET_OVERHEAD);
+              }
+          }
+      }
+
+    Ptr<Ipv4L3Protocol> ipv4 = node->GetObject<Ipv4L3Protocol> ();
+    if (ipv4 == 0)
+      {
+        return bytes;
+      }
+    bytes[IPV4] = sizeof (Ipv4L3Protocol) + ipv4->GetNInterfaces () * sizeof (Ipv4Interface);
+    for (uint32_t i = 0; i < ipv4->GetNInterfaces (); ++i)
+      {
+        Ptr<ArpCache> arp = ipv4->GetInterface (i)->GetArpCache ();
+        if (arp != 0)
+          {
+            std::ostringstream os;
+            arp->PrintArpCache (Create<OutputStreamWrapper> (&os));
+            bytes[ARP] += Lines (os.str ()) * ARP_ENTRY;
+          }
+      }
+    if (ipv4->GetRoutingProtocol () != 0)
+      {
+        std::ostringstream os;
+        ipv4->GetRoutingProtocol ()->PrintRoutingTable (Create<OutputStreamWrapper> (&os));
+        bytes[ROUTING] = Lines (os.str ()) * ROUTE_ENTRY;
+      }
+    return bytes;
+  }
+
+  static uint64_t Lines (const std::string &text)
+  {
+    return std::count (text.begin (), text.end (), '\n');
+  }
+
+  // Resident set size from /proc, 0 where that is not available
+  static uint64_t Rss ()
+  {
+    std::ifstream status ("/proc/self/status");
+    std::string line;
+    while (std::getline (status, line))
+      {
+        if (line.compare (0, 6, "VmRSS:") == 0)
+          {
+            return std::atol (line.c_str () + 6) * uint64_t (1024);
+          }
+      }
+    return 0;
+  }
+
+  static bool Heavier (const std::pair<uint64_t, uint32_t> &a, const std::pair<uint64_t, uint32_t> &b)
+  {
+    return a.first > b.first;
+  }
+
+  void PrintTable (std::ostream &os, const Sample &snap)
+  {
+    std::vector<uint64_t> total (LAYERS, 0);
+    std::vector<uint64_t> peak (LAYERS, 0);
+    std::vector<std::pair<uint64_t, uint32_t> > perNode;
+    uint64_t sum = 0;
+    for (uint32_t n = 0; n < snap.nodes.size (); ++n)
+      {
+        uint64_t node = 0;
+        for (uint32_t l = 0; l < LAYERS; ++l)
+          {
+            total[l] += snap.nodes[n][l];
+            peak[l] = std::max (peak[l], snap.nodes[n][l]);
+            node += snap.nodes[n][l];
+          }
+        perNode.push_back (std::make_pair (node, n));
+        sum += node;
+      }
+    uint32_t nodes = std::max<uint32_t> (1, snap.nodes.size ());
+
+    os << "Memory at " << snap.time << " s, " << snap.nodes.size () << " nodes, RSS "
+       << snap.rss / 1024 << " KiB, accounted " << sum / 1024 << " KiB\n";
+    os << "  " << std::left << std::setw (10) << "layer" << std::right
+       << std::setw (14) << "total KiB" << std::setw (14) << "per node B" << std::setw (14) << "max node B" << "\n";
+    for (uint32_t l = 0; l < LAYERS; ++l)
+      {
+        os << "  " << std::left << std::setw (10) << LayerName (l) << std::right
+           << std::setw (14) << total[l] / 1024 << std::setw (14) << total[l] / nodes
+           << std::setw (14) << peak[l] << "\n";
+      }
+    std::sort (perNode.begin (), perNode.end (), Heavier);
+    os << "  heaviest nodes:";
+    for (uint32_t i = 0; i < perNode.size () && i < 5; ++i)
+      {
+        os << " " << perNode[i].second << " (" << perNode[i].first << " B)";
+      }
+    os << "\n";
+  }
+
+  void WriteJson ()
+  {
+    std::ofstream out (m_fileName.c_str ());
+    out << "{\n  \"layers\": [";
+    for (uint32_t l = 0; l < LAYERS; ++l)
+      {
+        out << (l ? ", " : "") << "\"" << LayerName (l) << "\"";
+      }
+    out << "],\n  \"snapshots\": [\n";
+    for (uint32_t s = 0; s < m_snapshots.size (); ++s)
+      {
+        const Sample &snap = m_snapshots[s];
+        out << "    {\"time\": " << snap.time << ", \"rssBytes\": " << snap.rss << ", \"nodes\": [";
+        for (uint32_t n = 0; n < snap.nodes.size (); ++n)
+          {
+            out << (n ? ", " : "") << "[";
+            for (uint32_t l = 0; l < LAYERS; ++l)
+              {
+                out << (l ? ", " : "") << snap.nodes[n][l];
+              }
+            out << "]";
+          }
+        out << "]}" << (s + 1 < m_snapshots.size () ? "," : "") << "\n";
+      }
+    out << "  ]\n}\n";
+  }
+
+  bool m_enabled;
+  std::string m_times;
+  std::string m_fileName;
+  std::vector<Sample> m_snapshots;
+};
+
+} // namespace ns3
+
+#endif /* MEMORY_REPORT_H */
@@ -55,6 +55,12 @@
 // 
 // ./waf --run "wifi-simple-adhoc --sourceNode=20 --sinkNode=10"
 //
+// The packets are sent by a PacketTrain (packet-train.h), one event that
+// rearms itself, so long trains do not grow the event queue.  Run until
+// the train is done with --stopTime=0:
+//
+// ./waf --run "wifi-simple-adhoc-grid --numPackets=2000000 --interval=0.001 --stopTime=0"
+//
 // This script can also be helpful to put the Wifi layer into verbose
 // logging mode; this command will turn on all wifi logging:
 // 
@@ -79,6 +85,10 @@
 #include "ns3/ipv4-static-routing-helper.h"
 #include "ns3/ipv4-list-routing-helper.h"
 #include "ns3/netanim-module.h"
+#include "sampled-animation.h"
+#include "event-pool.h"
+#include "packet-train.h"
+#include "batched-loss-model.h"
 
 #include <iostream>
 #include <fstream>
@@ -103,8 +113,9 @@ static void GenerateTraffic (Ptr<Socket> socket, uint32_t pktSize,
   if (pktCount > 0)
     {
       socket->Send (Create<Packet> (pktSize));
-      Simulator::Schedule (pktInterval, &GenerateTraffic, 
-                           socket, pktSize,pktCount-1, pktInterval);
+      // pooled: the two event blocks alternate, no malloc per packet
+      PooledSchedule (pktInterval, &GenerateTraffic, 
+                      socket, pktSize,pktCount-1, pktInterval);
     }
   else
     {
@@ -126,6 +137,10 @@ int main (int argc, char *argv[])
   double interval = 1.0; // seconds
   bool verbose = false;
   bool tracing = false;
+  bool eventArena = false;
+  bool packetTrain = true;
+  bool batchedLoss = false;
+  double stopTime = 33.0; // seconds
 
   CommandLine cmd;
 
@@ -139,8 +154,15 @@ int main (int argc, char *argv[])
   cmd.AddValue ("numNodes", "number of nodes", numNodes);
   cmd.AddValue ("sinkNode", "Receiver node number", sinkNode);
   cmd.AddValue ("sourceNode", "Sender node number", sourceNode);
+  cmd.AddValue ("packetTrain", "send all packets from one self-rearming event (false: one event per packet)", packetTrain);
+  cmd.AddValue ("stopTime", "simulation end (seconds), 0 to run until the last packet is sent", stopTime);
+  cmd.AddValue ("eventArena", "Carve pooled events from a bump arena freed at the end", eventArena);
+  cmd.AddValue ("batchedLoss", "Friis loss to all receivers of a frame in one vectorized pass", batchedLoss);
+  SampledAnimation anim ("full", "animout.xml");
+  anim.AddCommandLine (cmd);
 
   cmd.Parse (argc, argv);
+  EventPool::SetArena (eventArena);
   // Convert to time object
   Time interPacketInterval = Seconds (interval);
 
@@ -168,10 +190,21 @@ int main (int argc, char *argv[])
   // ns-3 supports RadioTap and Prism tracing extensions for 802.11b
   wifiPhy.SetPcapDataLinkType (YansWifiPhyHelper::DLT_IEEE802_11_RADIO); 
 
-  YansWifiChannelHelper wifiChannel;
-  wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
-  wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel");
-  wifiPhy.SetChannel (wifiChannel.Create ());
+  if (batchedLoss)
+    {
+      // Same Friis loss, computed once per frame for the whole grid
+      Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+      channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      channel->SetPropagationLossModel (CreateObject<BatchedLossModel> ());
+      wifiPhy.SetChannel (channel);
+    }
+  else
+    {
+      YansWifiChannelHelper wifiChannel;
+      wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+      wifiChannel.AddPropagationLoss ("ns3::FriisPropagationLossModel");
+      wifiPhy.SetChannel (wifiChannel.Create ());
+    }
 
   // Add a non-QoS upper mac, and disable rate control
   NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
@@ -236,16 +269,35 @@ int main (int argc, char *argv[])
     }
 
   // Give OLSR time to converge-- 30 seconds perhaps
-  Simulator::Schedule (Seconds (30.0), &GenerateTraffic, 
-                       source, packetSize, numPackets, interPacketInterval);
+  Ptr<PacketTrain> train = Create<PacketTrain> (source, packetSize, numPackets, interPacketInterval);
+  if (packetTrain)
+    {
+      train->Start (Seconds (30.0));
+    }
+  else
+    {
+      PooledSchedule (Seconds (30.0), &GenerateTraffic, 
+                      source, packetSize, numPackets, interPacketInterval);
+    }
 
   // Output what we are doing
   NS_LOG_UNCOND ("Testing from node " << sourceNode << " to " << sinkNode << " with grid distance " << distance);
 
-  Simulator::Stop (Seconds (33.0));
-  AnimationInterface anim ("animout.xml");
+  if (stopTime <= 0)
+    {
+      stopTime = 30.0 + (numPackets + 1) * interval + 1.0;
+    }
+  Simulator::Stop (Seconds (stopTime));
+  anim.Install ();
   Simulator::Run ();
   Simulator::Destroy ();
+  anim.Close ();
+  if (packetTrain)
+    {
+      std::cout << "Packet train: " << train->GetSent () << " of " << numPackets << " packets sent\n";
+    }
+  EventPool::Print (std::cout);
+  EventPool::Reset ();
 
   return 0;
 }
@@ -25,10 +25,45 @@
  * 
  * This example illustrates the use of 
  *  - Wifi in ad-hoc mode
- *  - Matrix propagation loss model
+ *  - Sparse matrix propagation loss model (sparse-matrix-loss-model.h)
  *  - Use of OnOffApplication to generate CBR stream 
  *  - IP flow monitor
+ *
+ * Without arguments the two classic runs (RTS/CTS disabled and enabled) are
+ * made.  Any of --nodes, --rates, --sizes or --rts turns the program into a
+ * MAC-layer benchmark: the comma separated lists are swept as a Cartesian
+ * product over a star of nNodes - 1 mutually hidden senders around node 1,
+ * each variant runs in its own worker process (--jobs at a time), and one
+ * CSV line per variant reports the network metrics together with the
+ * simulator cost (events/s and wall seconds per simulated second).
+ * With --baseline=<previous csv> the run fails when a variant got slower
+ * than the baseline by more than --tolerance, so it doubles as a
+ * performance regression test:
+ *
+ * ./waf --run "myflow --nodes=3,5,9 --rates=1Mbps,3Mbps --rts=100,2200 --jobs=4 --output=mac.csv"
+ *
+ * --lossFile=<file> adds measured links ("tx rx lossDb" per line) on top of
+ * the star, so large measured topologies can be loaded without a dense
+ * nNodes x nNodes matrix.
+ *
+ * --classifier=index replaces FlowMonitor by FlowIndexMonitor
+ * (flow-index-monitor.h): the CBR senders stamp a flow index tag and each
+ * hop only updates a flat counter vector, which keeps the monitoring cost
+ * out of the simulator cost columns.
+ *
+ * --packetMetadata (packet-metadata.h) resolves to flowid for the ipv4
+ * classifier; an explicit none leaves FlowMonitor out, to measure what the
+ * flow id tags cost.
  */
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "ns3/core-module.h"
 #include "ns3/propagation-module.h"
 #include "ns3/network-module.h"
@@ -37,31 +72,79 @@
 #include "ns3/internet-module.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/wifi-module.h"
+#include "sparse-matrix-loss-model.h"
+#include "flow-index-monitor.h"
+#include "packet-metadata.h"
+#include "wall-clock.h"
 
 using namespace ns3;
 
-/// Run single 10 seconds experiment with enabled or disabled RTS/CTS mechanism
-void experiment (bool enableCtsRts)
+/// One point of the sweep
+struct Variant
+{
+  uint32_t nNodes;        ///< receiver plus nNodes - 1 hidden senders
+  std::string dataRate;   ///< offered load of each sender
+  uint32_t packetSize;    ///< CBR payload bytes
+  uint32_t rtsThreshold;  ///< RtsCtsThreshold; 2200 disables RTS/CTS
+};
+
+/// Network metrics and simulator cost of one run
+struct Result
 {
+  double txMbps;
+  double rxMbps;
+  double deliveryRatio;
+  double meanDelayMs;
+  uint64_t events;
+  double wallSeconds;
+};
+
+/// Optional measured loss matrix applied in every run
+static std::string g_lossFile;
+/// Flow statistics from FlowMonitor ("ipv4") or FlowIndexMonitor ("index")
+static std::string g_classifier = "ipv4";
+/// --packetMetadata; FlowMonitor is only installed when it allows flow ids
+static PacketMetadataLevel g_metadata;
+
+/// Run single experiment of \p duration seconds for one variant
+Result experiment (const Variant &v, double duration, bool verbose)
+{
+  double wallStart = WallClock ();
+  uint32_t receiver = 1;
+
   // 0. Enable or disable CTS/RTS
-  UintegerValue ctsThr = (enableCtsRts ? UintegerValue (100) : UintegerValue (2200));
-  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", ctsThr);
+  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", UintegerValue (v.rtsThreshold));
 
-  // 1. Create 3 nodes 
+  // 1. Create nodes 
   NodeContainer nodes;
-  nodes.Create (3);
+  nodes.Create (v.nNodes);
 
   // 2. Place nodes somehow, this is required by every wireless simulation
-  for (size_t i = 0; i < 3; ++i)
+  for (size_t i = 0; i < v.nNodes; ++i)
     {
       nodes.Get (i)->AggregateObject (CreateObject<ConstantPositionMobilityModel> ());
     }
 
-  // 3. Create propagation loss matrix
-  Ptr<MatrixPropagationLossModel> lossModel = CreateObject<MatrixPropagationLossModel> ();
+  // 3. Create propagation loss matrix: every sender hears only the receiver
+  Ptr<SparseMatrixLossModel> lossModel = CreateObject<SparseMatrixLossModel> ();
   lossModel->SetDefaultLoss (200); // set default loss to 200 dB (no link)
-  lossModel->SetLoss (nodes.Get (0)->GetObject<MobilityModel>(), nodes.Get (1)->GetObject<MobilityModel>(), 50); // set symmetric loss 0 <-> 1 to 50 dB
-  lossModel->SetLoss (nodes.Get (2)->GetObject<MobilityModel>(), nodes.Get (1)->GetObject<MobilityModel>(), 50); // set symmetric loss 2 <-> 1 to 50 dB
+  for (uint32_t i = 0; i < v.nNodes; ++i)
+    {
+      if (i != receiver)
+        {
+          // set symmetric loss i <-> receiver to 50 dB
+          lossModel->SetLoss (nodes.Get (i)->GetObject<MobilityModel>(), nodes.Get (receiver)->GetObject<MobilityModel>(), 50);
+        }
+    }
+  if (!g_lossFile.empty ())
+    {
+      uint32_t links = lossModel->LoadFile (g_lossFile, false);   // measured links are directed
+      if (verbose)
+        {
+          std::cout << "  Loss matrix: " << links << " links from " << g_lossFile << ", "
+                    << lossModel->GetMemoryBytes () << " bytes\n";
+        }
+    }
 
   // 4. Create & setup wifi channel
   Ptr<YansWifiChannel> wifiChannel = CreateObject <YansWifiChannel> ();
@@ -93,29 +176,34 @@ void experiment (bool enableCtsRts)
   internet.Install (nodes);
   Ipv4AddressHelper ipv4;
   ipv4.SetBase ("10.0.0.0", "255.0.0.0");
-  ipv4.Assign (devices);
+  Ipv4InterfaceContainer interfaces = ipv4.Assign (devices);
+  Ipv4Address sink = interfaces.GetAddress (receiver);
 
-  // 7. Install applications: two CBR streams each saturating the channel 
+  // 7. Install applications: one CBR stream per sender, all to the receiver
   ApplicationContainer cbrApps;
   uint16_t cbrPort = 12345;
-  OnOffHelper onOffHelper ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address ("10.0.0.2"), cbrPort));
-  onOffHelper.SetAttribute ("PacketSize", UintegerValue (1400));
+  OnOffHelper onOffHelper ("ns3::UdpSocketFactory", InetSocketAddress (sink, cbrPort));
+  onOffHelper.SetAttribute ("PacketSize", UintegerValue (v.packetSize));
   onOffHelper.SetAttribute ("OnTime",  StringValue ("ns3::ConstantRandomVariable[Constant=1]"));
   onOffHelper.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0]"));
 
-  // flow 1:  node 0 -> node 1
-  onOffHelper.SetAttribute ("DataRate", StringValue ("3000000bps"));
-  onOffHelper.SetAttribute ("StartTime", TimeValue (Seconds (1.000000)));
-  cbrApps.Add (onOffHelper.Install (nodes.Get (0))); 
-
-  // flow 2:  node 2 -> node 1
   /** \internal
    * The slightly different start times and data rates are a workaround
    * for \bugid{388} and \bugid{912}
    */
-  onOffHelper.SetAttribute ("DataRate", StringValue ("3001100bps"));
-  onOffHelper.SetAttribute ("StartTime", TimeValue (Seconds (1.001)));
-  cbrApps.Add (onOffHelper.Install (nodes.Get (2))); 
+  uint64_t bitRate = DataRate (v.dataRate).GetBitRate ();
+  uint32_t sender = 0;
+  for (uint32_t i = 0; i < v.nNodes; ++i)
+    {
+      if (i == receiver)
+        {
+          continue;
+        }
+      onOffHelper.SetAttribute ("DataRate", DataRateValue (DataRate (bitRate + sender * 1100)));
+      onOffHelper.SetAttribute ("StartTime", TimeValue (Seconds (1.000000 + sender * 0.001)));
+      cbrApps.Add (onOffHelper.Install (nodes.Get (i)));
+      ++sender;
+    }
 
   /** \internal
    * We also use separate UDP applications that will send a single
@@ -123,65 +211,349 @@ void experiment (bool enableCtsRts)
    * This is a workaround for the lack of perfect ARP, see \bugid{187}
    */
   uint16_t  echoPort = 9;
-  UdpEchoClientHelper echoClientHelper (Ipv4Address ("10.0.0.2"), echoPort);
+  UdpEchoClientHelper echoClientHelper (sink, echoPort);
   echoClientHelper.SetAttribute ("MaxPackets", UintegerValue (1));
   echoClientHelper.SetAttribute ("Interval", TimeValue (Seconds (0.1)));
   echoClientHelper.SetAttribute ("PacketSize", UintegerValue (10));
   ApplicationContainer pingApps;
 
   // again using different start times to workaround Bug 388 and Bug 912
-  echoClientHelper.SetAttribute ("StartTime", TimeValue (Seconds (0.001)));
-  pingApps.Add (echoClientHelper.Install (nodes.Get (0))); 
-  echoClientHelper.SetAttribute ("StartTime", TimeValue (Seconds (0.006)));
-  pingApps.Add (echoClientHelper.Install (nodes.Get (2)));
-
-
-
+  sender = 0;
+  for (uint32_t i = 0; i < v.nNodes; ++i)
+    {
+      if (i == receiver)
+        {
+          continue;
+        }
+      echoClientHelper.SetAttribute ("StartTime", TimeValue (Seconds (0.001 + sender * 0.005)));
+      pingApps.Add (echoClientHelper.Install (nodes.Get (i)));
+      ++sender;
+    }
 
-  // 8. Install FlowMonitor on all nodes
+  // 8. Install FlowMonitor on all nodes, or tag the CBR flows for FlowIndexMonitor
   FlowMonitorHelper flowmon;
-  Ptr<FlowMonitor> monitor = flowmon.InstallAll ();
+  Ptr<FlowMonitor> monitor;
+  FlowIndexMonitor indexMonitor;
+  if (g_classifier == "index")
+    {
+      for (uint32_t i = 0; i < cbrApps.GetN (); ++i)
+        {
+          indexMonitor.AddFlow (cbrApps.Get (i));
+        }
+      indexMonitor.Install (nodes);
+    }
+  else if (g_metadata.AllowsFlowIds ())
+    {
+      monitor = flowmon.InstallAll ();
+    }
 
-  // 9. Run simulation for 10 seconds
-  Simulator::Stop (Seconds (10));
+  // 9. Run simulation
+  Simulator::Stop (Seconds (duration));
   Simulator::Run ();
 
-  // 10. Print per flow statistics
-  monitor->CheckForLostPackets ();
-  Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
-  FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
-  for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
+  // 10. Collect per flow statistics
+  //
+  // Duration for throughput measurement is duration - 1 seconds, since 
+  //   StartTime of the OnOffApplication is at about "second 1"
+  // and 
+  //   Simulator::Stops at "second duration".
+  double measured = duration - 1.0;
+  Result result = { 0, 0, 0, 0, 0, 0 };
+  uint64_t txPackets = 0;
+  uint64_t rxPackets = 0;
+  Time delaySum;
+  for (uint32_t i = 0; i < indexMonitor.GetNFlows (); ++i)
+    {
+      // only CBR flows carry a flow index
+      const FlowIndexMonitor::FlowCounters &c = indexMonitor.Get (i);
+      result.txMbps += c.txBytes * 8.0 / measured / 1000 / 1000;
+      result.rxMbps += c.rxBytes * 8.0 / measured / 1000 / 1000;
+      txPackets += c.txPackets;
+      rxPackets += c.rxPackets;
+      delaySum += TimeStep (c.delaySum);
+      if (verbose)
+        {
+          std::cout << "Flow " << i + 1 << " (index)\n";
+          std::cout << "  Tx Packets: " << c.txPackets << "\n";
+          std::cout << "  Tx Bytes:   " << c.txBytes << "\n";
+          std::cout << "  TxOffered:  " << c.txBytes * 8.0 / measured / 1000 / 1000  << " Mbps\n";
+          std::cout << "  Rx Packets: " << c.rxPackets << "\n";
+          std::cout << "  Rx Bytes:   " << c.rxBytes << "\n";
+          std::cout << "  Throughput: " << c.rxBytes * 8.0 / measured / 1000 / 1000  << " Mbps\n";
+        }
+    }
+  if (monitor)
     {
-      // first 2 FlowIds are for ECHO apps, we don't want to display them
-      //
-      // Duration for throughput measurement is 9.0 seconds, since 
-      //   StartTime of the OnOffApplication is at about "second 1"
-      // and 
-      //   Simulator::Stops at "second 10".
-      if (i->first > 2)
+      monitor->CheckForLostPackets ();
+      Ptr<Ipv4FlowClassifier> classifier = DynamicCast<Ipv4FlowClassifier> (flowmon.GetClassifier ());
+      FlowMonitor::FlowStatsContainer stats = monitor->GetFlowStats ();
+      uint32_t flow = 0;
+      for (std::map<FlowId, FlowMonitor::FlowStats>::const_iterator i = stats.begin (); i != stats.end (); ++i)
         {
+          // ECHO flows are not part of the measurement
           Ipv4FlowClassifier::FiveTuple t = classifier->FindFlow (i->first);
-          std::cout << "Flow " << i->first - 2 << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
-          std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
-          std::cout << "  Tx Bytes:   " << i->second.txBytes << "\n";
-          std::cout << "  TxOffered:  " << i->second.txBytes * 8.0 / 9.0 / 1000 / 1000  << " Mbps\n";
-          std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
-          std::cout << "  Rx Bytes:   " << i->second.rxBytes << "\n";
-          std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / 9.0 / 1000 / 1000  << " Mbps\n";
+          if (t.destinationPort != cbrPort)
+            {
+              continue;
+            }
+          result.txMbps += i->second.txBytes * 8.0 / measured / 1000 / 1000;
+          result.rxMbps += i->second.rxBytes * 8.0 / measured / 1000 / 1000;
+          txPackets += i->second.txPackets;
+          rxPackets += i->second.rxPackets;
+          delaySum += i->second.delaySum;
+          if (verbose)
+            {
+              std::cout << "Flow " << ++flow << " (" << t.sourceAddress << " -> " << t.destinationAddress << ")\n";
+              std::cout << "  Tx Packets: " << i->second.txPackets << "\n";
+              std::cout << "  Tx Bytes:   " << i->second.txBytes << "\n";
+              std::cout << "  TxOffered:  " << i->second.txBytes * 8.0 / measured / 1000 / 1000  << " Mbps\n";
+              std::cout << "  Rx Packets: " << i->second.rxPackets << "\n";
+              std::cout << "  Rx Bytes:   " << i->second.rxBytes << "\n";
+              std::cout << "  Throughput: " << i->second.rxBytes * 8.0 / measured / 1000 / 1000  << " Mbps\n";
+            }
         }
     }
+  result.deliveryRatio = txPackets ? double (rxPackets) / txPackets : 0;
+  result.meanDelayMs = rxPackets ? delaySum.GetSeconds () * 1000 / rxPackets : 0;
+  result.events = Simulator::GetEventCount ();
 
   // 11. Cleanup
   Simulator::Destroy ();
+  result.wallSeconds = WallClock () - wallStart;
+  return result;
+}
+
+static std::vector<std::string>
+SplitList (std::string list)
+{
+  std::vector<std::string> items;
+  std::istringstream in (list);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      if (!item.empty ())
+        {
+          items.push_back (item);
+        }
+    }
+  return items;
+}
+
+static std::string
+CsvKey (const Variant &v)
+{
+  std::ostringstream os;
+  os << v.nNodes << "," << v.dataRate << "," << v.packetSize << "," << v.rtsThreshold;
+  return os.str ();
+}
+
+static std::string
+CsvLine (const Variant &v, const Result &r, double duration)
+{
+  std::ostringstream os;
+  os << CsvKey (v) << "," << r.txMbps << "," << r.rxMbps << "," << r.deliveryRatio << "," << r.meanDelayMs
+     << "," << r.events << "," << r.wallSeconds << "," << r.events / r.wallSeconds
+     << "," << r.wallSeconds / duration << "\n";
+  return os.str ();
+}
+
+/// Run every variant in a forked worker, at most \p jobs at a time; lines are returned in variant order
+static std::vector<std::string>
+RunParallel (const std::vector<Variant> &variants, double duration, uint32_t jobs)
+{
+  std::vector<std::string> lines (variants.size ());
+  std::map<pid_t, std::pair<uint32_t, int> > running;   // worker -> (variant, pipe)
+  uint32_t next = 0;
+  std::cout.flush ();
+  while (next < variants.size () || !running.empty ())
+    {
+      while (next < variants.size () && running.size () < jobs)
+        {
+          int fds[2];
+          if (pipe (fds) != 0)
+            {
+              std::cout << "pipe failed\n";
+              exit (1);
+            }
+          pid_t pid = fork ();
+          if (pid == 0)
+            {
+              close (fds[0]);
+              // a CSV line is far below PIPE_BUF, so this write never blocks
+              std::string line = CsvLine (variants[next], experiment (variants[next], duration, false), duration);
+              ssize_t written = write (fds[1], line.c_str (), line.size ());
+              _exit (written == ssize_t (line.size ()) ? 0 : 1);
+            }
+          close (fds[1]);
+          running[pid] = std::make_pair (next, fds[0]);
+          ++next;
+        }
+
+      int status;
+      pid_t done = wait (&status);
+      std::map<pid_t, std::pair<uint32_t, int> >::iterator it = running.find (done);
+      if (it == running.end ())
+        {
+          continue;
+        }
+      char buffer[512];
+      ssize_t n;
+      while ((n = read (it->second.second, buffer, sizeof (buffer))) > 0)
+        {
+          lines[it->second.first].append (buffer, n);
+        }
+      close (it->second.second);
+      if (lines[it->second.first].empty ())
+        {
+          std::cout << "Variant " << CsvKey (variants[it->second.first]) << " failed\n";
+        }
+      running.erase (it);
+    }
+  return lines;
+}
+
+/// Compare wall seconds per simulated second against a previous CSV; returns the number of regressions
+static uint32_t
+CompareBaseline (std::string baseline, const std::vector<std::string> &lines, double tolerance)
+{
+  std::map<std::string, double> reference;
+  std::ifstream in (baseline.c_str ());
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::vector<std::string> cols = SplitList (line);
+      if (cols.size () == 12 && cols[0] != "nodes")
+        {
+          reference[cols[0] + "," + cols[1] + "," + cols[2] + "," + cols[3]] = std::atof (cols[11].c_str ());
+        }
+    }
+
+  uint32_t regressions = 0;
+  for (uint32_t i = 0; i < lines.size (); ++i)
+    {
+      std::vector<std::string> cols = SplitList (lines[i].substr (0, lines[i].find ('\n')));
+      if (cols.size () != 12)
+        {
+          continue;
+        }
+      std::string key = cols[0] + "," + cols[1] + "," + cols[2] + "," + cols[3];
+      std::map<std::string, double>::const_iterator ref = reference.find (key);
+      double cost = std::atof (cols[11].c_str ());
+      if (ref != reference.end () && cost > ref->second * (1 + tolerance))
+        {
+          std::cout << "REGRESSION " << key << ": " << cost << " wall s per simulated s, baseline " << ref->second << "\n";
+          ++regressions;
+        }
+    }
+  return regressions;
 }
 
 int main (int argc, char **argv)
 {
-  std::cout << "Hidden station experiment with RTS/CTS disabled:\n" << std::flush;
-  experiment (false);
-  std::cout << "------------------------------------------------\n";
-  std::cout << "Hidden station experiment with RTS/CTS enabled:\n";
-  experiment (true);
+  std::string nodes;
+  std::string rates;
+  std::string sizes;
+  std::string rts;
+  double duration = 10;
+  uint32_t jobs = 1;
+  std::string output;
+  std::string baseline;
+  double tolerance = 0.2;
+
+  CommandLine cmd;
+  cmd.AddValue ("nodes", "Sweep: node counts, e.g. 3,5,9", nodes);
+  cmd.AddValue ("rates", "Sweep: per-sender offered loads, e.g. 1Mbps,3Mbps", rates);
+  cmd.AddValue ("sizes", "Sweep: packet sizes in bytes, e.g. 500,1400", sizes);
+  cmd.AddValue ("rts", "Sweep: RTS thresholds, e.g. 100,2200", rts);
+  cmd.AddValue ("duration", "Simulated seconds per run", duration);
+  cmd.AddValue ("jobs", "Worker processes running at the same time", jobs);
+  cmd.AddValue ("output", "Also write the sweep CSV to this file", output);
+  cmd.AddValue ("baseline", "Previous sweep CSV to check for slowdowns", baseline);
+  cmd.AddValue ("tolerance", "Allowed slowdown against the baseline (0.2 = 20%)", tolerance);
+  cmd.AddValue ("classifier", "Flow statistics: ipv4 (FlowMonitor) or index (flow index tags)", g_classifier);
+  cmd.AddValue ("lossFile", "Measured loss matrix, one \"tx rx lossDb\" link per line", g_lossFile);
+  g_metadata.AddCommandLine (cmd);
+  cmd.Parse (argc, argv);
+  if (g_classifier != "ipv4" && g_classifier != "index")
+    {
+      std::cout << "Unknown classifier " << g_classifier << "\n";
+      return 1;
+    }
+  if (!g_metadata.Resolve (false, g_classifier == "ipv4"))
+    {
+      std::cout << "Unknown packetMetadata level\n";
+      return 1;
+    }
+  if (g_classifier == "ipv4" && !g_metadata.AllowsFlowIds ())
+    {
+      std::cout << "FlowMonitor off with --packetMetadata=" << g_metadata.GetName () << ", no ipv4 flow statistics\n";
+    }
+
+  if (nodes.empty () && rates.empty () && sizes.empty () && rts.empty ())
+    {
+      Variant basic = { 3, "3000000bps", 1400, 2200 };
+      Variant rtscts = { 3, "3000000bps", 1400, 100 };
+      std::cout << "Hidden station experiment with RTS/CTS disabled:\n" << std::flush;
+      Result r = experiment (basic, duration, true);
+      std::cout << "  Cost:       " << r.events / r.wallSeconds << " events/s, " << r.wallSeconds / duration << " wall s per simulated s\n";
+      std::cout << "------------------------------------------------\n";
+      std::cout << "Hidden station experiment with RTS/CTS enabled:\n";
+      r = experiment (rtscts, duration, true);
+      std::cout << "  Cost:       " << r.events / r.wallSeconds << " events/s, " << r.wallSeconds / duration << " wall s per simulated s\n";
+      return 0;
+    }
+
+  std::vector<std::string> nodeList = SplitList (nodes.empty () ? "3" : nodes);
+  std::vector<std::string> rateList = SplitList (rates.empty () ? "3000000bps" : rates);
+  std::vector<std::string> sizeList = SplitList (sizes.empty () ? "1400" : sizes);
+  std::vector<std::string> rtsList = SplitList (rts.empty () ? "100,2200" : rts);
+  std::vector<Variant> variants;
+  for (uint32_t a = 0; a < nodeList.size (); ++a)
+    {
+      for (uint32_t b = 0; b < rateList.size (); ++b)
+        {
+          for (uint32_t c = 0; c < sizeList.size (); ++c)
+            {
+              for (uint32_t d = 0; d < rtsList.size (); ++d)
+                {
+                  Variant v = { uint32_t (std::atoi (nodeList[a].c_str ())), rateList[b],
+                                uint32_t (std::atoi (sizeList[c].c_str ())), uint32_t (std::atoi (rtsList[d].c_str ())) };
+                  if (v.nNodes < 2)
+                    {
+                      std::cout << "Need at least 2 nodes\n";
+                      exit (1);
+                    }
+                  variants.push_back (v);
+                }
+            }
+        }
+    }
 
-  return 0;
+  std::vector<std::string> lines = RunParallel (variants, duration, jobs > 0 ? jobs : 1);
+  std::string header = "nodes,rate,packetSize,rtsThreshold,txMbps,rxMbps,deliveryRatio,meanDelayMs,events,wallSeconds,eventsPerSecond,wallPerSimSecond\n";
+  std::ofstream file;
+  if (!output.empty ())
+    {
+      file.open (output.c_str ());
+      file << header;
+    }
+  std::cout << header;
+  uint32_t failed = 0;
+  for (uint32_t i = 0; i < lines.size (); ++i)
+    {
+      std::cout << lines[i];
+      if (file.is_open ())
+        {
+          file << lines[i];
+        }
+      failed += lines[i].empty ();
+    }
+
+  // a crashed variant has no row, so the baseline check cannot see it
+  uint32_t regressions = baseline.empty () ? 0 : CompareBaseline (baseline, lines, tolerance);
+  if (failed > 0)
+    {
+      std::cout << failed << " of " << lines.size () << " variants failed\n";
+    }
+  return failed > 0 || regressions > 0 ? 1 : 0;
 }
@@ -54,6 +54,7 @@
 #include "ns3/netanim-module.h"
 #include <sstream>
 #include <iostream>
+#include "pcap-capture.h"
 
 
 NS_LOG_COMPONENT_DEFINE ("SiftTest");
@@ -100,6 +101,7 @@ private:
   int yDistance;                                //y distance between two consecutive nodes in grid topology
   double gridWidth;                     //Number of nodes on each line of grid
   bool pcap;                                    //enable disable pcap report files
+  PcapCapture capture;   // pcap filters, see pcap-capture.h
   NodeContainer adhocNodes;
   NetDeviceContainer allDevices;
   Ipv4InterfaceContainer allInterfaces;
@@ -166,6 +168,8 @@ SiftTest::Configure (int argc, char **argv)
   cmd.AddValue ("packetSize", "The packet size", packetSize);
   cmd.AddValue ("txpDistance", "Specify node's transmit range, Default:250", txpDistance);
   cmd.AddValue ("pauseTime", "pauseTime for mobility model, Default: 100", pauseTime);
+  cmd.AddValue ("pcap", "Enable pcap capture, Default:true", pcap);
+  capture.AddCommandLine (cmd);
 
   cmd.Parse (argc, argv);
 
@@ -314,42 +318,42 @@ SiftTest::CreateDevices ()
       stream = ascii.CreateFileStream ("siftTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("siftpcap"));
+          capture.Install (wifiPhy, "siftpcap", allDevices);
         }
       break;
    /* case LAR:
       stream = ascii.CreateFileStream ("larTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("larpcap"));
+          capture.Install (wifiPhy, "larpcap", allDevices);
         }
       break; */
     case AODV:
       stream = ascii.CreateFileStream ("aodvTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("aodvpcap"));
+          capture.Install (wifiPhy, "aodvpcap", allDevices);
         }
       break;
     case DSDV:
       stream = ascii.CreateFileStream ("dsdvTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("dsdvpcap"));
+          capture.Install (wifiPhy, "dsdvpcap", allDevices);
         }
       break;
     case DSR:
       stream = ascii.CreateFileStream ("dsrTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("dsrpcap"));
+          capture.Install (wifiPhy, "dsrpcap", allDevices);
         }
       break;
     case OLSR:
       stream = ascii.CreateFileStream ("olsrTrace.tr");
       if (pcap)
         {
-          wifiPhy.EnablePcapAll (std::string ("olsrpcap"));
+          capture.Install (wifiPhy, "olsrpcap", allDevices);
         }
       break;
     }
@@ -46,6 +46,7 @@
 #include "ns3/netanim-module.h"
 #include "ns3/flow-monitor-module.h"
 #include "ns3/propagation-module.h"
+#include "pcap-capture.h"
 
 using namespace ns3;
 
@@ -88,6 +89,7 @@ private:
   uint32_t seedval;
   int initGridSpacing;              // distance between nodes in grid topology
   bool pcap;             // PCAP enable/disable
+  PcapCapture capture;   // pcap filters, see pcap-capture.h
   double xmax;                 // x length of Mobility area
   double ymax;                 // y length of Mobility area
   double zmax;                  
@@ -173,6 +175,8 @@ DGGFtest::Configure (int argc, char **argv)
   cmd.AddValue ("TxMaxRange", "Specify node's transmit range, Default:250", TxMaxRange);
   cmd.AddValue ("nodePauseTime", "Specify node max pause time, Default:0" , nodePauseTime);
   cmd.AddValue ("seedval", "Specify a new seed for the run.  Default:1", seedval);
+  cmd.AddValue ("pcap", "Enable pcap capture, Default:false", pcap);
+  capture.AddCommandLine (cmd);
   cmd.Parse (argc, argv);
   return true;
 }
@@ -329,7 +333,7 @@ DGGFtest::CreateDevices ()
 
   if (pcap)
     {
-      wifiPhy.EnablePcapAll (std::string ("Siftpcap"));
+      capture.Install (wifiPhy, "Siftpcap", allDevices);
     }
 
   //NS_LOG_INFO ("Configure Tracing.");
@@ -26,6 +26,7 @@
 #include "ns3/sift-module.h"
 #include "ns3/sift-helper.h"
 #include "ns3/sift-main-helper.h"
+#include "sampled-animation.h"
 
 // Default Network Topology
 //
@@ -53,6 +54,8 @@ main (int argc, char *argv[])
   cmd.AddValue ("nCsma", "Number of \"extra\" CSMA nodes/devices", nCsma);
   cmd.AddValue ("nWifi", "Number of wifi STA devices", nWifi);
   cmd.AddValue ("verbose", "Tell echo applications to log if true", verbose);
+  SampledAnimation anim ("full", "anim3.xml");
+  anim.AddCommandLine (cmd);
 
   cmd.Parse (argc,argv);
 
@@ -198,9 +201,10 @@ main (int argc, char *argv[])
   phy.EnablePcap ("third", apDevices.Get (0));
   csma.EnablePcap ("third", csmaDevices.Get (0), true);
 
-  AnimationInterface anim ("anim3.xml");
+  anim.Install ();
  
   Simulator::Run ();
   Simulator::Destroy ();
+  anim.Close ();
   return 0;
 }
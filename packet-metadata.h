@@ -0,0 +1,150 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_METADATA_H
+#define PACKET_METADATA_H
+
+#include <iostream>
+#include <string>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/wifi-module.h"
+#include "wall-clock.h"
+
+namespace ns3 {
+
+/*
+ * One knob for what every packet carries besides its bytes, --packetMetadata:
+ *   none    no header metadata and no tags
+ *   flowid  flow id byte tags only, as added by FlowMonitor
+ *   full    header metadata (Packet::EnablePrinting), needed by ascii traces
+ *   auto    the least of the above the enabled outputs need (default)
+ * Resolve () must run before the first packet exists, since metadata
+ * cannot be switched on for packets already created.  Outputs then ask
+ * AllowsAscii () / AllowsFlowIds () before installing themselves, so an
+ * explicit lower level also turns those outputs off.
+ *
+ * StartCost () / StopCost () around Simulator::Run () count transmitted
+ * Wi-Fi frames and ReportCost () prints the wall time per frame, to compare
+ * the levels on the same scenario; packet-cost-bench.cc measures the bare
+ * per-packet cost of each level.
+ */
+class PacketMetadataLevel
+{
+public:
+  enum Level
+  {
+    NONE, FLOW_ID, FULL
+  };
+
+  PacketMetadataLevel ()
+    : m_name ("auto"),
+      m_level (FULL),
+      m_frames (0),
+      m_wallStart (0),
+      m_wallSeconds (0)
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("packetMetadata", "Packet metadata/tags: auto, none, flowid or full, Default:auto", m_name);
+  }
+
+  // Returns false for an unknown level name
+  bool Resolve (bool asciiTrace, bool flowMonitor)
+  {
+    if (m_name == "auto")
+      {
+        m_level = asciiTrace ? FULL : (flowMonitor ? FLOW_ID : NONE);
+      }
+    else if (m_name == "none")
+      {
+        m_level = NONE;
+      }
+    else if (m_name == "flowid")
+      {
+        m_level = FLOW_ID;
+      }
+    else if (m_name == "full")
+      {
+        m_level = FULL;
+      }
+    else
+      {
+        return false;
+      }
+    if (m_level == FULL)
+      {
+        Packet::EnablePrinting ();
+      }
+    return true;
+  }
+
+  bool AllowsAscii () const
+  {
+    return m_level == FULL;
+  }
+
+  bool AllowsFlowIds () const
+  {
+    return m_level >= FLOW_ID;
+  }
+
+  std::string GetName () const
+  {
+    const char *names[] = { "none", "flowid", "full" };
+    return names[m_level];
+  }
+
+  void StartCost ()
+  {
+    Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxBegin",
+                                   MakeCallback (&PacketMetadataLevel::PhyTx, this));
+    m_wallStart = WallClock ();
+  }
+
+  void StopCost ()
+  {
+    m_wallSeconds = WallClock () - m_wallStart;
+  }
+
+  void ReportCost (std::ostream &os) const
+  {
+    os << "Packet metadata " << GetName () << ": " << m_frames << " frames sent";
+    if (m_frames > 0)
+      {
+        os << ", " << m_wallSeconds * 1e6 / m_frames << " us wall per frame";
+      }
+    os << "\n";
+  }
+
+private:
+  void PhyTx (Ptr<const Packet> p)
+  {
+    ++m_frames;
+  }
+
+  std::string m_name;
+  Level m_level;
+  uint64_t m_frames;
+  double m_wallStart;
+  double m_wallSeconds;
+};
+
+} // namespace ns3
+
+#endif /* PACKET_METADATA_H */
@@ -0,0 +1,85 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PACKET_TRAIN_H
+#define PACKET_TRAIN_H
+
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+
+namespace ns3 {
+
+/*
+ * A whole packet train as one self-rearming event.  The train is its own
+ * EventImpl: each Notify () sends one packet and schedules the same object
+ * again, so a train of any length keeps exactly one entry in the event
+ * queue and allocates nothing per packet but the packet itself.  Packet k
+ * leaves at start + k * interval, computed from integer time steps, so long
+ * trains do not drift.  As with the recursive GenerateTraffic, the socket
+ * is closed one interval after the last packet.
+ */
+class PacketTrain : public EventImpl
+{
+public:
+  PacketTrain (Ptr<Socket> socket, uint32_t pktSize, uint32_t pktCount, Time interval)
+    : m_socket (socket),
+      m_pktSize (pktSize),
+      m_pktCount (pktCount),
+      m_interval (interval.GetTimeStep ()),
+      m_start (0),
+      m_sent (0)
+  {
+  }
+
+  // First packet after delay
+  void Start (Time delay)
+  {
+    m_start = (Simulator::Now () + delay).GetTimeStep ();
+    m_sent = 0;
+    Simulator::Schedule (delay, Ptr<EventImpl> (this));
+  }
+
+  uint32_t GetSent () const
+  {
+    return m_sent;
+  }
+
+private:
+  virtual void Notify (void)
+  {
+    if (m_sent == m_pktCount)
+      {
+        m_socket->Close ();
+        return;
+      }
+    // size only: the payload stays a virtual zero area until serialized
+    m_socket->Send (Create<Packet> (m_pktSize));
+    ++m_sent;
+    Time next = TimeStep (m_start + m_sent * m_interval);
+    Simulator::Schedule (next - Simulator::Now (), Ptr<EventImpl> (this));
+  }
+
+  Ptr<Socket> m_socket;
+  uint32_t m_pktSize;
+  uint32_t m_pktCount;
+  int64_t m_interval;   // time steps
+  int64_t m_start;      // time step of packet 0
+  uint32_t m_sent;
+};
+
+} // namespace ns3
+
+#endif /* PACKET_TRAIN_H */
@@ -0,0 +1,215 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PATH_TRACER_H
+#define PATH_TRACER_H
+
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/wifi-module.h"
+#include "run-results.h"
+
+namespace ns3 {
+
+/*
+ * Path length and route stability per flow, enabled with --pathStats.
+ * Every WifiNetDevice MacTx adds the transmitting node to the path of the
+ * packet, so the tracer works the same for IP forwarding (AODV, DSDV,
+ * OLSR) and for the source routed and geographic protocols (DSR, SIFT)
+ * that forward below IP.  A packet's path is kept as a hop count and an
+ * FNV-1a hash of the node ids in a slot of a ring indexed by packet uid;
+ * uids only grow, so a slot is simply reused by a later packet and
+ * nothing needs to be purged.  When a PacketSink receives the packet the
+ * path is folded into the counters of its flow (first transmitter, sink
+ * node): delivered packets, mean and max hops, route changes (a path
+ * hash differing from the previous packet's) and distinct paths per
+ * second.  Packets whose slot was taken over before delivery, i.e. more
+ * than --pathWindow packets later, are counted as untracked.  Without
+ * --pathStats nothing is connected and the run pays nothing.
+ */
+class PathTracer
+{
+public:
+  PathTracer ()
+    : m_enabled (false),
+      m_window (65536),
+      m_untracked (0)
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("pathStats", "Report hop counts and route changes per flow, Default:false", m_enabled);
+    cmd.AddValue ("pathWindow", "Packets in flight tracked by pathStats, Default:65536", m_window);
+  }
+
+  // Call once the devices and sinks exist, before Simulator::Run ()
+  void Install ()
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    m_slots.assign (std::max (m_window, 1u), Slot ());
+    Config::Connect ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Mac/MacTx",
+                     MakeCallback (&PathTracer::MacTx, this));
+    Config::Connect ("/NodeList/*/ApplicationList/*/$ns3::PacketSink/Rx",
+                     MakeCallback (&PathTracer::SinkRx, this));
+  }
+
+  void Report (std::ostream &os, RunResults &results)
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    uint64_t delivered = 0, hops = 0, changes = 0, distinct = 0, seconds = 0;
+    uint32_t maxHops = 0;
+    for (std::map<uint64_t, Flow>::iterator f = m_flows.begin (); f != m_flows.end (); ++f)
+      {
+        Flow &flow = f->second;
+        flow.CloseSecond ();
+        os << "Path " << (f->first >> 32) << "->" << (f->first & 0xffffffff) << ": " << flow.delivered
+           << " delivered, " << double (flow.hops) / flow.delivered << " hops mean, " << flow.maxHops << " max, "
+           << flow.changes << " route changes, " << double (flow.distinct) / flow.seconds << " distinct paths/s\n";
+        delivered += flow.delivered;
+        hops += flow.hops;
+        changes += flow.changes;
+        distinct += flow.distinct;
+        seconds += flow.seconds;
+        maxHops = std::max (maxHops, flow.maxHops);
+      }
+    os << "Paths: " << m_flows.size () << " flows, " << delivered << " packets traced, " << m_untracked
+       << " untracked\n";
+    results.Add ("pathFlows", m_flows.size ());
+    results.Add ("pathDelivered", delivered);
+    results.Add ("pathUntracked", m_untracked);
+    results.Add ("pathMeanHops", delivered ? double (hops) / delivered : 0);
+    results.Add ("pathMaxHops", maxHops);
+    results.Add ("pathChanges", changes);
+    results.Add ("pathDistinctPerSecond", seconds ? double (distinct) / seconds : 0);
+  }
+
+private:
+  struct Slot
+  {
+    Slot ()
+      : uid (~uint64_t (0)), first (0), last (0), hops (0), hash (0)
+    {
+    }
+
+    uint64_t uid;
+    uint32_t first;    // node of the first transmission
+    uint32_t last;     // node of the latest transmission
+    uint32_t hops;
+    uint64_t hash;
+  };
+
+  struct Flow
+  {
+    Flow ()
+      : delivered (0), hops (0), maxHops (0), changes (0), lastHash (0),
+        second (-1), distinct (0), seconds (0)
+    {
+    }
+
+    // The paths seen in the current second count towards distinct/seconds
+    void CloseSecond ()
+    {
+      distinct += secondHashes.size ();
+      seconds += !secondHashes.empty ();
+      secondHashes.clear ();
+    }
+
+    uint64_t delivered;
+    uint64_t hops;
+    uint32_t maxHops;
+    uint64_t changes;
+    uint64_t lastHash;
+    int64_t second;
+    uint64_t distinct;   // sum over seconds of the paths used in that second
+    uint64_t seconds;    // seconds with deliveries
+    std::vector<uint64_t> secondHashes;
+  };
+
+  static uint32_t ContextNode (const std::string &context)
+  {
+    return std::atoi (context.c_str () + 10);   // "/NodeList/<id>/..."
+  }
+
+  void MacTx (std::string context, Ptr<const Packet> packet)
+  {
+    uint32_t node = ContextNode (context);
+    Slot &s = m_slots[packet->GetUid () % m_slots.size ()];
+    if (s.uid != packet->GetUid ())
+      {
+        s = Slot ();
+        s.uid = packet->GetUid ();
+        s.first = node;
+        s.hash = 14695981039346656037ULL;
+      }
+    else if (s.last == node)
+      {
+        return;   // the same node sending it again, not a new hop
+      }
+    s.last = node;
+    ++s.hops;
+    s.hash = (s.hash ^ node) * 1099511628211ULL;
+  }
+
+  void SinkRx (std::string context, Ptr<const Packet> packet, const Address &from)
+  {
+    const Slot &s = m_slots[packet->GetUid () % m_slots.size ()];
+    if (s.uid != packet->GetUid ())
+      {
+        ++m_untracked;
+        return;
+      }
+    Flow &flow = m_flows[(uint64_t (s.first) << 32) | ContextNode (context)];
+    flow.changes += flow.delivered > 0 && s.hash != flow.lastHash;
+    flow.lastHash = s.hash;
+    ++flow.delivered;
+    flow.hops += s.hops;
+    flow.maxHops = std::max (flow.maxHops, s.hops);
+    int64_t second = Simulator::Now ().GetSeconds ();
+    if (second != flow.second)
+      {
+        flow.CloseSecond ();
+        flow.second = second;
+      }
+    if (std::find (flow.secondHashes.begin (), flow.secondHashes.end (), s.hash) == flow.secondHashes.end ())
+      {
+        flow.secondHashes.push_back (s.hash);
+      }
+  }
+
+  bool m_enabled;
+  uint32_t m_window;
+  uint64_t m_untracked;
+  std::vector<Slot> m_slots;            // by packet uid modulo the window
+  std::map<uint64_t, Flow> m_flows;     // by (first transmitter << 32 | sink node)
+};
+
+} // namespace ns3
+
+#endif /* PATH_TRACER_H */
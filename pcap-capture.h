@@ -0,0 +1,239 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef PCAP_CAPTURE_H
+#define PCAP_CAPTURE_H
+
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/wifi-module.h"
+
+namespace ns3 {
+
+/*
+ * Capture-time filtering for the wifi pcap traces.  Install () is a drop-in
+ * for wifiPhy.EnablePcapAll (prefix): with every option left at its default
+ * it calls exactly that, otherwise it writes one 802.11 pcap per device from
+ * the PhyTxBegin/PhyRxEnd traces and keeps only frames passing the filters:
+ *   --pcapFrames   all, data (802.11 data frames) or routing (AODV, OLSR and
+ *                  DSDV UDP ports, or IP protocol 48 as used by DSR)
+ *   --pcapPorts    UDP/TCP port list, e.g. "9,654"; matches src or dst
+ *   --pcapNodes    node list, e.g. "0-9,15"
+ *   --pcapSnapLen  bytes kept from each frame, 0 for the whole frame
+ *   --pcapSample   keep 1 in N frames, chosen by packet uid so a sampled
+ *                  packet is captured on every hop
+ * Filters are checked cheapest first; headers are only parsed when
+ * --pcapFrames or --pcapPorts needs them.
+ */
+class PcapCapture
+{
+public:
+  PcapCapture ()
+    : m_frames ("all"),
+      m_snapLen (0),
+      m_sample (1),
+      m_seen (0),
+      m_written (0)
+  {
+  }
+
+  ~PcapCapture ()
+  {
+    if (m_seen > 0)
+      {
+        std::cout << "pcap: " << m_written << " of " << m_seen << " frames written\n";
+      }
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("pcapFrames", "pcap frame filter: all, data or routing", m_frames);
+    cmd.AddValue ("pcapPorts", "pcap UDP/TCP port filter, e.g. 9,654 (empty for all)", m_ports);
+    cmd.AddValue ("pcapNodes", "pcap node subset, e.g. 0-9,15 (empty for all)", m_nodes);
+    cmd.AddValue ("pcapSnapLen", "pcap bytes kept per frame, 0 for all", m_snapLen);
+    cmd.AddValue ("pcapSample", "pcap keeps 1 in N frames", m_sample);
+  }
+
+  void Install (YansWifiPhyHelper &wifiPhy, std::string prefix, NetDeviceContainer devices)
+  {
+    if (m_frames == "all" && m_ports.empty () && m_nodes.empty () && m_snapLen == 0 && m_sample <= 1)
+      {
+        wifiPhy.EnablePcapAll (prefix);
+        return;
+      }
+    NS_ABORT_MSG_IF (m_frames != "all" && m_frames != "data" && m_frames != "routing",
+                     "Unknown pcapFrames " << m_frames);
+    if (m_sample == 0)
+      {
+        m_sample = 1;
+      }
+    ParseList ("pcapPorts", m_ports, 65535, m_portSet);
+    ParseList ("pcapNodes", m_nodes, NodeList::GetNNodes () - 1, m_nodeSet);
+
+    PcapHelper pcapHelper;
+    uint32_t snapLen = m_snapLen > 0 ? m_snapLen : 65535;
+    for (uint32_t i = 0; i < devices.GetN (); ++i)
+      {
+        Ptr<WifiNetDevice> device = DynamicCast<WifiNetDevice> (devices.Get (i));
+        if (device == 0 || (!m_nodeSet.empty () && m_nodeSet.count (device->GetNode ()->GetId ()) == 0))
+          {
+            continue;
+          }
+        std::string name = pcapHelper.GetFilenameFromDevice (prefix, device);
+        Ptr<PcapFileWrapper> file = pcapHelper.CreateFile (name, std::ios::out, PcapHelper::DLT_IEEE802_11, snapLen);
+        device->GetPhy ()->TraceConnectWithoutContext ("PhyTxBegin", MakeBoundCallback (&PcapCapture::Frame, this, file));
+        device->GetPhy ()->TraceConnectWithoutContext ("PhyRxEnd", MakeBoundCallback (&PcapCapture::Frame, this, file));
+      }
+  }
+
+private:
+  static void Frame (PcapCapture *capture, Ptr<PcapFileWrapper> file, Ptr<const Packet> p)
+  {
+    ++capture->m_seen;
+    if (p->GetUid () % capture->m_sample != 0 || !capture->Match (p))
+      {
+        return;
+      }
+    ++capture->m_written;
+    file->Write (Simulator::Now (), p);
+  }
+
+  bool Match (Ptr<const Packet> p) const
+  {
+    if (m_frames == "all" && m_portSet.empty ())
+      {
+        return true;
+      }
+    Ptr<Packet> copy = p->Copy ();
+    WifiMacHeader mac;
+    copy->RemoveHeader (mac);
+    if (!mac.IsData ())
+      {
+        return false;
+      }
+    if (m_frames == "data" && m_portSet.empty ())
+      {
+        return true;
+      }
+
+    LlcSnapHeader llc;
+    copy->RemoveHeader (llc);
+    if (llc.GetType () != Ipv4L3Protocol::PROT_NUMBER)
+      {
+        return false;
+      }
+    Ipv4Header ip;
+    copy->RemoveHeader (ip);
+    uint16_t src = 0;
+    uint16_t dst = 0;
+    if (ip.GetFragmentOffset () == 0 && ip.GetProtocol () == UdpL4Protocol::PROT_NUMBER)
+      {
+        UdpHeader udp;
+        copy->PeekHeader (udp);
+        src = udp.GetSourcePort ();
+        dst = udp.GetDestinationPort ();
+      }
+    else if (ip.GetFragmentOffset () == 0 && ip.GetProtocol () == TcpL4Protocol::PROT_NUMBER)
+      {
+        TcpHeader tcp;
+        copy->PeekHeader (tcp);
+        src = tcp.GetSourcePort ();
+        dst = tcp.GetDestinationPort ();
+      }
+
+    if (m_frames == "routing" && !IsRouting (ip.GetProtocol (), src, dst))
+      {
+        return false;
+      }
+    return m_portSet.empty () || m_portSet.count (src) || m_portSet.count (dst);
+  }
+
+  // DSR carries data inside its own header, so every DSR frame counts here
+  static bool IsRouting (uint8_t protocol, uint16_t src, uint16_t dst)
+  {
+    const uint16_t aodvPort = 654;
+    const uint16_t olsrPort = 698;
+    const uint16_t dsdvPort = 269;
+    const uint8_t dsrProtocol = 48;
+    return protocol == dsrProtocol
+           || src == aodvPort || dst == aodvPort
+           || src == olsrPort || dst == olsrPort
+           || src == dsdvPort || dst == dsdvPort;
+  }
+
+  // "0-9,15" -> {0..9, 15}; every value must lie in [0, max]
+  static void ParseList (std::string name, std::string list, uint32_t max, std::set<uint32_t> &values)
+  {
+    values.clear ();
+    std::istringstream in (list);
+    std::string item;
+    while (std::getline (in, item, ','))
+      {
+        if (item.empty ())
+          {
+            continue;
+          }
+        std::string::size_type dash = item.find ('-');
+        uint32_t first = ParseValue (name, item.substr (0, dash), max);
+        uint32_t last = first;
+        if (dash != std::string::npos)
+          {
+            last = ParseValue (name, item.substr (dash + 1), max);
+          }
+        NS_ABORT_MSG_IF (last < first, "Empty range " << item << " in " << name);
+        for (uint32_t v = first; ; ++v)
+          {
+            values.insert (v);
+            if (v == last)
+              {
+                break;
+              }
+          }
+      }
+  }
+
+  static uint32_t ParseValue (std::string name, std::string text, uint32_t max)
+  {
+    char *end = 0;
+    unsigned long value = std::strtoul (text.c_str (), &end, 10);
+    NS_ABORT_MSG_IF (text.empty () || text[0] == '-' || *end != '\0',
+                     "Bad value '" << text << "' in " << name);
+    NS_ABORT_MSG_IF (value > max, "Value " << text << " in " << name << " is above " << max);
+    return value;
+  }
+
+  std::string m_frames;
+  std::string m_ports;
+  std::string m_nodes;
+  uint32_t m_snapLen;
+  uint32_t m_sample;
+
+  std::set<uint32_t> m_portSet;
+  std::set<uint32_t> m_nodeSet;
+  uint64_t m_seen;
+  uint64_t m_written;
+};
+
+} // namespace ns3
+
+#endif /* PCAP_CAPTURE_H */
@@ -0,0 +1,189 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RADIO_ENERGY_H
+#define RADIO_ENERGY_H
+
+#include <algorithm>
+#include <iostream>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/energy-module.h"
+#include "ns3/wifi-module.h"
+#include "run-results.h"
+
+namespace ns3 {
+
+/*
+ * Battery powered radios, enabled with --energy: a BasicEnergySource of
+ * --energyInitialJ joules at --energyVoltage volts on every node and a
+ * WifiRadioEnergyModel on every wifi device.  The radio model already
+ * integrates the current of the state it leaves on each PHY state change
+ * and updates its source there; what costs events is the source's
+ * periodic update, one per node every second by default.  With
+ * --energyUpdate=0 (the default) the period is pushed past the end of the
+ * run, so energy is only accounted on state transitions and by reading
+ * the sources in an event at the stop time, when they still integrate up
+ * to the current time (once Run () has returned they no longer do).  The
+ * totals are taken from the sources (initial minus remaining energy per
+ * node), not from the radio models, whose consumption stops at their last
+ * state change and would miss each radio's idle tail.  A run the budget
+ * cuts short never reaches that event; Finish () then reads the sources
+ * as of their last update.
+ *
+ * A battery is depleted when it falls to the source's low battery
+ * threshold, which turns its radio off; without periodic updates that is
+ * noticed at the node's next state change.  A positive --energyUpdate
+ * restores periodic updates with that period in seconds.  The default
+ * 10 kJ keeps an idle radio going for over three hours of simulated time;
+ * Report () warns, with the time each one went flat, when batteries ran
+ * out during the run.  It adds the energy consumed, the most any node
+ * used, the number of depleted batteries, the first depletion time and
+ * the energy per delivered payload bit to the run results.
+ */
+class RadioEnergy
+{
+public:
+  RadioEnergy ()
+    : m_enabled (false),
+      m_initialJ (10000),
+      m_voltage (3.0),
+      m_update (0),
+      m_totalJ (0),
+      m_maxJ (0),
+      m_depleted (0),
+      m_read (false)
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("energy", "Battery and wifi radio energy models on all nodes, Default:false", m_enabled);
+    cmd.AddValue ("energyInitialJ", "Initial battery energy per node in J, Default:10000", m_initialJ);
+    cmd.AddValue ("energyVoltage", "Battery supply voltage in V, Default:3.0", m_voltage);
+    cmd.AddValue ("energyUpdate", "Periodic battery update interval in s, 0 for state changes only, Default:0", m_update);
+  }
+
+  // Call once the wifi devices exist, before Simulator::Stop (); stopTime is the end of the run
+  void Install (NodeContainer nodes, NetDeviceContainer devices, double stopTime)
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    BasicEnergySourceHelper source;
+    source.Set ("BasicEnergySourceInitialEnergyJ", DoubleValue (m_initialJ));
+    source.Set ("BasicEnergySupplyVoltageV", DoubleValue (m_voltage));
+    source.Set ("PeriodicEnergyUpdateInterval", TimeValue (Seconds (m_update > 0 ? m_update : stopTime + 1)));
+    m_sources = source.Install (nodes);
+    WifiRadioEnergyModelHelper radio;
+    m_radios = radio.Install (devices, m_sources);
+    m_depletedAt.assign (m_sources.GetN (), -1);
+    for (uint32_t i = 0; i < m_sources.GetN (); ++i)
+      {
+        m_sources.Get (i)->TraceConnectWithoutContext ("RemainingEnergy",
+                                                       MakeBoundCallback (&RadioEnergy::RemainingEnergy, this, i));
+      }
+    // scheduled before the stop event of the same time, so it runs first
+    Simulator::Schedule (Seconds (stopTime), &RadioEnergy::Read, this);
+  }
+
+  // Call after Simulator::Run () and before Simulator::Destroy ()
+  void Finish ()
+  {
+    if (m_enabled && !m_read)
+      {
+        Read ();
+      }
+  }
+
+  void Report (std::ostream &os, RunResults &results, uint64_t rxBytes)
+  {
+    if (!m_enabled)
+      {
+        return;
+      }
+    double perBitNJ = rxBytes > 0 ? m_totalJ / (rxBytes * 8.0) * 1e9 : 0;
+    os << "Energy: " << m_totalJ << " J by " << m_sources.GetN () << " nodes (at most " << m_maxJ << " J), "
+       << m_depleted << " batteries depleted, " << perBitNJ << " nJ per delivered bit\n";
+    double first = -1;
+    if (m_depleted > 0)
+      {
+        os << "Warning: batteries ran out during the run (node at s):";
+        for (uint32_t i = 0; i < m_depletedAt.size (); ++i)
+          {
+            if (m_depletedAt[i] >= 0)
+              {
+                os << " " << i << "@" << m_depletedAt[i];
+                first = first < 0 ? m_depletedAt[i] : std::min (first, m_depletedAt[i]);
+              }
+          }
+        os << "\n";
+      }
+    results.Add ("energyJ", m_totalJ);
+    results.Add ("energyMaxNodeJ", m_maxJ);
+    results.Add ("energyDepleted", m_depleted);
+    results.Add ("energyFirstDepletedAt", first);
+    results.Add ("energyPerBitNJ", perBitNJ);
+  }
+
+private:
+  // Notes when source i first falls to its low battery threshold
+  static void RemainingEnergy (RadioEnergy *self, uint32_t i, double oldJ, double newJ)
+  {
+    if (self->m_depletedAt[i] >= 0)
+      {
+        return;
+      }
+    DoubleValue threshold;
+    self->m_sources.Get (i)->GetAttribute ("BasicEnergyLowBatteryThreshold", threshold);
+    if (newJ <= threshold.Get () * self->m_sources.Get (i)->GetInitialEnergy ())
+      {
+        self->m_depletedAt[i] = Simulator::Now ().GetSeconds ();
+        ++self->m_depleted;
+      }
+  }
+
+  void Read ()
+  {
+    m_read = true;
+    for (uint32_t i = 0; i < m_sources.GetN (); ++i)
+      {
+        // brings the source up to now, i.e. integrates the current state
+        Ptr<EnergySource> source = m_sources.Get (i);
+        double j = source->GetInitialEnergy () - source->GetRemainingEnergy ();
+        m_totalJ += j;
+        m_maxJ = std::max (m_maxJ, j);
+      }
+  }
+
+  bool m_enabled;
+  double m_initialJ;
+  double m_voltage;
+  double m_update;         // seconds, 0 for state changes only
+  EnergySourceContainer m_sources;
+  DeviceEnergyModelContainer m_radios;
+  double m_totalJ;
+  double m_maxJ;
+  uint32_t m_depleted;
+  std::vector<double> m_depletedAt;   // simulated seconds per node, -1 if never
+  bool m_read;
+};
+
+} // namespace ns3
+
+#endif /* RADIO_ENERGY_H */
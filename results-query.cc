@@ -0,0 +1,160 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Reads a columnar results file (results-store.h) written by the routing
+ * scenarios with --store, e.g. the results.rcs of a sweep.
+ *
+ * ./waf --run "results-query --store=sweep/results.rcs --info"
+ *     columns with their types, rows, and the time to scan each column
+ * ./waf --run "results-query --store=sweep/results.rcs --columns=nNodes,throughputKbps"
+ *     the selected columns (default all) as TSV on stdout, for plotting
+ * ./waf --run "results-query --store=sweep/results.rcs --stats=throughputKbps"
+ *     count, mean, min and max of numeric columns
+ * ./waf --run "results-query --store=sweep/results.rcs --compact=all.rcs"
+ *     all rows rewritten as one block, for faster scans
+ */
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "results-store.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+static std::vector<std::string>
+SplitList (std::string list)
+{
+  std::vector<std::string> out;
+  std::istringstream in (list);
+  std::string item;
+  while (std::getline (in, item, ','))
+    {
+      if (!item.empty ())
+        {
+          out.push_back (item);
+        }
+    }
+  return out;
+}
+
+int main (int argc, char **argv)
+{
+  std::string storeName;
+  std::string columns;
+  std::string stats;
+  std::string compact;
+  bool info = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("store", "Columnar results file", storeName);
+  cmd.AddValue ("columns", "Comma separated columns to print, default all", columns);
+  cmd.AddValue ("stats", "Comma separated numeric columns to summarise", stats);
+  cmd.AddValue ("compact", "Rewrite all rows as one block to this file", compact);
+  cmd.AddValue ("info", "List the columns and scan times", info);
+  cmd.Parse (argc, argv);
+
+  ResultsStore store;
+  if (!store.Open (storeName))
+    {
+      std::cerr << "Cannot read results file " << storeName << "\n";
+      return 1;
+    }
+
+  if (info)
+    {
+      const char *types[] = { "int", "real", "text" };
+      std::cout << store.GetNRows () << " rows, " << store.GetColumnNames ().size () << " columns\n";
+      for (uint32_t c = 0; c < store.GetColumnNames ().size (); ++c)
+        {
+          std::string name = store.GetColumnNames ()[c];
+          std::vector<std::string> values;
+          double start = WallClock ();
+          store.Scan (name, values);
+          std::cout << "  " << std::left << std::setw (20) << name << std::setw (6) << types[store.GetType (name)]
+                    << std::right << std::fixed << std::setprecision (3) << (WallClock () - start) * 1e3
+                    << " ms scan\n";
+        }
+      return 0;
+    }
+
+  if (!compact.empty ())
+    {
+      if (!store.Compact (compact))
+        {
+          std::cerr << "Cannot write " << compact << "\n";
+          return 1;
+        }
+      std::cout << store.GetNRows () << " rows written to " << compact << "\n";
+      return 0;
+    }
+
+  if (!stats.empty ())
+    {
+      std::vector<std::string> names = SplitList (stats);
+      std::cout << "column\tcount\tmean\tmin\tmax\n";
+      for (uint32_t c = 0; c < names.size (); ++c)
+        {
+          std::vector<double> v;
+          if (!store.Scan (names[c], v))
+            {
+              std::cerr << "No column " << names[c] << "\n";
+              return 1;
+            }
+          uint64_t n = 0;
+          double sum = 0, lo = 0, hi = 0;
+          for (uint64_t r = 0; r < v.size (); ++r)
+            {
+              if (v[r] != v[r])
+                {
+                  continue;
+                }
+              lo = n == 0 || v[r] < lo ? v[r] : lo;
+              hi = n == 0 || v[r] > hi ? v[r] : hi;
+              sum += v[r];
+              ++n;
+            }
+          std::cout << names[c] << "\t" << n << "\t" << (n ? sum / n : 0) << "\t" << lo << "\t" << hi << "\n";
+        }
+      return 0;
+    }
+
+  std::vector<std::string> names = columns.empty () ? store.GetColumnNames () : SplitList (columns);
+  std::vector<std::vector<std::string> > data (names.size ());
+  for (uint32_t c = 0; c < names.size (); ++c)
+    {
+      if (!store.Scan (names[c], data[c]))
+        {
+          std::cerr << "No column " << names[c] << "\n";
+          return 1;
+        }
+      std::cout << (c ? "\t" : "") << names[c];
+    }
+  std::cout << "\n";
+  for (uint64_t r = 0; r < store.GetNRows (); ++r)
+    {
+      for (uint32_t c = 0; c < names.size (); ++c)
+        {
+          std::cout << (c ? "\t" : "") << data[c][r];
+        }
+      std::cout << "\n";
+    }
+  return 0;
+}
@@ -0,0 +1,504 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RESULTS_STORE_H
+#define RESULTS_STORE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <sstream>
+#include <stdint.h>
+#include <string>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <unistd.h>
+
+namespace ns3 {
+
+/*
+ * Columnar file of run results.  The file is a sequence of blocks, each
+ * holding some rows column by column:
+ *
+ *   uint32 magic, uint32 block bytes, uint32 rows, uint32 columns
+ *   per column: uint16 name length, name, uint8 type, uint32 data bytes
+ *   per column: the data, int64 or double per row for INT and REAL,
+ *               uint32 length + bytes per row for TEXT
+ *
+ * Append () writes one row as one block with a single write () under an
+ * exclusive flock (), so any number of runs may append to the same file
+ * at once.  Column types follow the values: integers are INT, other
+ * numbers REAL, anything else TEXT.  A reader Open ()s the file by reading
+ * the block headers only; Scan () then reads just the named column of
+ * every block.  Compact () rewrites the file as a single block, with the
+ * union of all columns (missing cells are INT64_MIN, NaN or empty and a
+ * column with mixed types is widened to REAL or TEXT), which makes a scan
+ * over tens of thousands of runs one read per column.
+ */
+class ResultsStore
+{
+public:
+  enum Type
+  {
+    INT, REAL, TEXT
+  };
+
+  typedef std::vector<std::pair<std::string, std::string> > Row;
+
+  // INT cell of a row that has no value for the column
+  static int64_t MissingInt ()
+  {
+    return std::numeric_limits<int64_t>::min ();
+  }
+
+  static bool Append (std::string fileName, const Row &row)
+  {
+    std::vector<Column> columns;
+    for (uint32_t i = 0; i < row.size (); ++i)
+      {
+        Column c;
+        c.name = row[i].first;
+        c.type = TypeOf (row[i].second);
+        c.Push (row[i].second);
+        columns.push_back (c);
+      }
+    std::string block = Encode (columns, 1);
+    int fd = open (fileName.c_str (), O_WRONLY | O_APPEND | O_CREAT, 0644);
+    if (fd < 0)
+      {
+        return false;
+      }
+    flock (fd, LOCK_EX);
+    bool ok = write (fd, block.data (), block.size ()) == ssize_t (block.size ());
+    flock (fd, LOCK_UN);
+    close (fd);
+    return ok;
+  }
+
+  ResultsStore ()
+    : m_file (0),
+      m_rows (0)
+  {
+  }
+
+  ~ResultsStore ()
+  {
+    Close ();
+  }
+
+  // Reads the block directory; false if the file is missing or damaged
+  bool Open (std::string fileName)
+  {
+    Close ();
+    m_file = std::fopen (fileName.c_str (), "rb");
+    if (m_file == 0)
+      {
+        return false;
+      }
+    flock (fileno (m_file), LOCK_SH);   // no half written block at the end
+    bool ok = ReadDirectory ();
+    flock (fileno (m_file), LOCK_UN);
+    return ok;
+  }
+
+  uint64_t GetNRows () const
+  {
+    return m_rows;
+  }
+
+  const std::vector<std::string> &GetColumnNames () const
+  {
+    return m_names;
+  }
+
+  // Widest type the column has in any block
+  Type GetType (std::string name) const
+  {
+    std::map<std::string, Type>::const_iterator i = m_types.find (name);
+    return i == m_types.end () ? TEXT : i->second;
+  }
+
+  // Numeric values of a column, NaN where a row has none or text
+  bool Scan (std::string name, std::vector<double> &out)
+  {
+    Column c;
+    if (!Read (name, c))
+      {
+        return false;
+      }
+    out.resize (m_rows);
+    for (uint64_t r = 0; r < m_rows; ++r)
+      {
+        out[r] = c.AsReal (r);
+      }
+    return true;
+  }
+
+  // Any column as text, empty where a row has no value
+  bool Scan (std::string name, std::vector<std::string> &out)
+  {
+    Column c;
+    if (!Read (name, c))
+      {
+        return false;
+      }
+    out.resize (m_rows);
+    for (uint64_t r = 0; r < m_rows; ++r)
+      {
+        out[r] = c.AsText (r);
+      }
+    return true;
+  }
+
+  // Writes all rows to fileName as one block
+  bool Compact (std::string fileName)
+  {
+    std::vector<Column> columns;
+    for (uint32_t i = 0; i < m_names.size (); ++i)
+      {
+        columns.push_back (Column ());
+        if (!Read (m_names[i], columns.back ()))
+          {
+            return false;
+          }
+      }
+    std::string block = Encode (columns, m_rows);
+    FILE *out = std::fopen (fileName.c_str (), "wb");
+    if (out == 0)
+      {
+        return false;
+      }
+    bool ok = std::fwrite (block.data (), 1, block.size (), out) == block.size ();
+    return std::fclose (out) == 0 && ok;
+  }
+
+private:
+  static const uint32_t MAGIC = 0x31534352;   // "RCS1"
+
+  struct Segment
+  {
+    Type type;
+    uint64_t offset;
+    uint32_t bytes;
+  };
+
+  struct Block
+  {
+    uint32_t rows;
+    std::map<std::string, Segment> columns;
+  };
+
+  struct Column
+  {
+    std::string name;
+    Type type;
+    std::vector<int64_t> ints;
+    std::vector<double> reals;
+    std::vector<std::string> texts;
+
+    void Push (const std::string &v)
+    {
+      if (type == INT)
+        {
+          ints.push_back (std::strtoll (v.c_str (), 0, 10));
+        }
+      else if (type == REAL)
+        {
+          reals.push_back (std::strtod (v.c_str (), 0));
+        }
+      else
+        {
+          texts.push_back (v);
+        }
+    }
+
+    double AsReal (uint64_t r) const
+    {
+      if (type == INT)
+        {
+          return ints[r] == MissingInt () ? std::numeric_limits<double>::quiet_NaN () : double (ints[r]);
+        }
+      return type == REAL ? reals[r] : std::numeric_limits<double>::quiet_NaN ();
+    }
+
+    std::string AsText (uint64_t r) const
+    {
+      if (type == TEXT)
+        {
+          return texts[r];
+        }
+      double v = AsReal (r);
+      if (v != v)
+        {
+          return "";
+        }
+      std::ostringstream os;
+      os.precision (15);
+      if (type == INT)
+        {
+          os << ints[r];
+        }
+      else
+        {
+          os << v;
+        }
+      return os.str ();
+    }
+  };
+
+  static Type TypeOf (const std::string &v)
+  {
+    char *end;
+    std::strtoll (v.c_str (), &end, 10);
+    if (!v.empty () && *end == '\0')
+      {
+        return INT;
+      }
+    std::strtod (v.c_str (), &end);
+    return !v.empty () && *end == '\0' ? REAL : TEXT;
+  }
+
+  static void Put (std::string &out, const void *data, uint32_t bytes)
+  {
+    out.append (static_cast<const char *> (data), bytes);
+  }
+
+  static std::string Encode (const std::vector<Column> &columns, uint64_t rows)
+  {
+    std::vector<std::string> data (columns.size ());
+    for (uint32_t c = 0; c < columns.size (); ++c)
+      {
+        const Column &col = columns[c];
+        for (uint64_t r = 0; r < rows; ++r)
+          {
+            if (col.type == INT)
+              {
+                Put (data[c], &col.ints[r], 8);
+              }
+            else if (col.type == REAL)
+              {
+                Put (data[c], &col.reals[r], 8);
+              }
+            else
+              {
+                uint32_t len = col.texts[r].size ();
+                Put (data[c], &len, 4);
+                data[c] += col.texts[r];
+              }
+          }
+      }
+    std::string header;
+    for (uint32_t c = 0; c < columns.size (); ++c)
+      {
+        uint16_t len = columns[c].name.size ();
+        uint8_t type = columns[c].type;
+        uint32_t bytes = data[c].size ();
+        Put (header, &len, 2);
+        header += columns[c].name;
+        Put (header, &type, 1);
+        Put (header, &bytes, 4);
+      }
+    uint32_t head[4] = { MAGIC, 0, uint32_t (rows), uint32_t (columns.size ()) };
+    std::string block;
+    Put (block, head, sizeof (head));
+    block += header;
+    for (uint32_t c = 0; c < data.size (); ++c)
+      {
+        block += data[c];
+      }
+    uint32_t size = block.size ();
+    std::memcpy (&block[4], &size, 4);
+    return block;
+  }
+
+  bool ReadDirectory ()
+  {
+    uint64_t offset = 0;
+    uint32_t head[4];
+    while (std::fread (head, sizeof (head), 1, m_file) == 1)
+      {
+        if (head[0] != MAGIC || head[1] < sizeof (head))
+          {
+            return false;
+          }
+        Block b;
+        b.rows = head[2];
+        uint64_t data = offset + sizeof (head);
+        std::vector<std::pair<std::string, std::pair<uint8_t, uint32_t> > > desc;
+        for (uint32_t c = 0; c < head[3]; ++c)
+          {
+            uint16_t len;
+            uint8_t type;
+            uint32_t bytes;
+            std::string name;
+            if (std::fread (&len, 2, 1, m_file) != 1)
+              {
+                return false;
+              }
+            name.resize (len);
+            if ((len > 0 && std::fread (&name[0], len, 1, m_file) != 1)
+                || std::fread (&type, 1, 1, m_file) != 1 || std::fread (&bytes, 4, 1, m_file) != 1)
+              {
+                return false;
+              }
+            desc.push_back (std::make_pair (name, std::make_pair (type, bytes)));
+            data += 2 + len + 1 + 4;
+          }
+        for (uint32_t c = 0; c < desc.size (); ++c)
+          {
+            Segment s = { Type (desc[c].second.first), data, desc[c].second.second };
+            b.columns[desc[c].first] = s;
+            data += desc[c].second.second;
+            if (m_types.count (desc[c].first) == 0)
+              {
+                m_names.push_back (desc[c].first);
+                m_types[desc[c].first] = s.type;
+              }
+            else if (m_types[desc[c].first] != s.type)
+              {
+                m_types[desc[c].first] = std::max (m_types[desc[c].first], s.type);
+              }
+          }
+        m_blocks.push_back (b);
+        m_rows += b.rows;
+        offset += head[1];
+        if (data != offset || std::fseek (m_file, offset, SEEK_SET) != 0)
+          {
+            return false;
+          }
+      }
+    return true;
+  }
+
+  // Gathers a column over all blocks, widened to its widest type
+  bool Read (std::string name, Column &c)
+  {
+    if (m_types.count (name) == 0)
+      {
+        return false;
+      }
+    c.name = name;
+    c.type = m_types[name];
+    std::string buf;
+    for (uint32_t b = 0; b < m_blocks.size (); ++b)
+      {
+        uint32_t rows = m_blocks[b].rows;
+        std::map<std::string, Segment>::const_iterator s = m_blocks[b].columns.find (name);
+        if (s == m_blocks[b].columns.end ())
+          {
+            for (uint32_t r = 0; r < rows; ++r)
+              {
+                PushMissing (c);
+              }
+            continue;
+          }
+        buf.resize (s->second.bytes);
+        if (std::fseek (m_file, s->second.offset, SEEK_SET) != 0
+            || (buf.size () > 0 && std::fread (&buf[0], buf.size (), 1, m_file) != 1))
+          {
+            return false;
+          }
+        Column part;
+        part.type = s->second.type;
+        const char *p = buf.data ();
+        for (uint32_t r = 0; r < rows; ++r)
+          {
+            if (part.type == TEXT)
+              {
+                uint32_t len;
+                std::memcpy (&len, p, 4);
+                part.texts.push_back (std::string (p + 4, len));
+                p += 4 + len;
+              }
+            else if (part.type == INT)
+              {
+                int64_t v;
+                std::memcpy (&v, p, 8);
+                part.ints.push_back (v);
+                p += 8;
+              }
+            else
+              {
+                double v;
+                std::memcpy (&v, p, 8);
+                part.reals.push_back (v);
+                p += 8;
+              }
+          }
+        for (uint32_t r = 0; r < rows; ++r)
+          {
+            if (c.type == part.type && c.type == INT)
+              {
+                c.ints.push_back (part.ints[r]);
+              }
+            else if (c.type == REAL)
+              {
+                c.reals.push_back (part.AsReal (r));
+              }
+            else
+              {
+                c.texts.push_back (part.AsText (r));
+              }
+          }
+      }
+    return true;
+  }
+
+  static void PushMissing (Column &c)
+  {
+    if (c.type == INT)
+      {
+        c.ints.push_back (MissingInt ());
+      }
+    else if (c.type == REAL)
+      {
+        c.reals.push_back (std::numeric_limits<double>::quiet_NaN ());
+      }
+    else
+      {
+        c.texts.push_back ("");
+      }
+  }
+
+  void Close ()
+  {
+    if (m_file != 0)
+      {
+        std::fclose (m_file);
+        m_file = 0;
+      }
+    m_blocks.clear ();
+    m_names.clear ();
+    m_types.clear ();
+    m_rows = 0;
+  }
+
+  FILE *m_file;
+  uint64_t m_rows;
+  std::vector<Block> m_blocks;
+  std::vector<std::string> m_names;
+  std::map<std::string, Type> m_types;
+};
+
+} // namespace ns3
+
+#endif /* RESULTS_STORE_H */
@@ -0,0 +1,192 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RUN_BUDGET_H
+#define RUN_BUDGET_H
+
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/resource.h>
+#include "ns3/core-module.h"
+#include "run-results.h"
+
+namespace ns3 {
+
+/*
+ * Wall-clock, event-count and memory budgets for one run, so that a
+ * pathological point of a sweep cannot hold a worker for hours:
+ *   --maxWallSeconds  wall time of Simulator::Run ()
+ *   --maxEvents       events executed
+ *   --maxRssMiB       peak resident set size
+ * 0 disables a budget.  A check event runs every --budgetCheck simulated
+ * seconds, which must be positive (IsValid ()); the first budget found
+ * exceeded stops the simulator, so Run () carries on as after a normal
+ * stop and Report () still prints and stores the metrics gathered so far.
+ * Report () adds "truncated" (0 or 1), the budget that stopped the run and
+ * the simulated time it reached to the run results.
+ *
+ * Each check also takes a progress snapshot: simulated time, events, wall
+ * seconds and peak RSS.  --progress rewrites it to a file at every check,
+ * so a run killed from outside still shows how far it got, and once more
+ * from Report () with the final figures.  A truncated run prints the
+ * snapshot taken when it stopped.
+ */
+class RunBudget
+{
+public:
+  RunBudget ()
+    : m_maxWallSeconds (0),
+      m_maxEvents (0),
+      m_maxRssMiB (0),
+      m_checkInterval (0.1),
+      m_start (0),
+      m_stoppedAt (-1)
+  {
+    m_progress.time = 0;
+    m_progress.events = 0;
+    m_progress.wallSeconds = 0;
+    m_progress.rssMiB = 0;
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("maxWallSeconds", "Stop the run after this many wall-clock seconds, 0 for no limit", m_maxWallSeconds);
+    cmd.AddValue ("maxEvents", "Stop the run after this many events, 0 for no limit", m_maxEvents);
+    cmd.AddValue ("maxRssMiB", "Stop the run when its peak RSS exceeds this many MiB, 0 for no limit", m_maxRssMiB);
+    cmd.AddValue ("budgetCheck", "Simulated seconds between budget checks, Default:0.1", m_checkInterval);
+    cmd.AddValue ("progress", "Rewrite the run's progress snapshot to this file at every budget check", m_progressFile);
+  }
+
+  // Returns false for a check interval that would not advance the clock
+  bool IsValid () const
+  {
+    return m_checkInterval > 0;
+  }
+
+  // Call right before Simulator::Run ()
+  void Install ()
+  {
+    m_start = WallClock ();
+    if (m_maxWallSeconds <= 0 && m_maxEvents == 0 && m_maxRssMiB == 0 && m_progressFile.empty ())
+      {
+        return;
+      }
+    Simulator::Schedule (Seconds (m_checkInterval), &RunBudget::Check, this);
+  }
+
+  bool IsTruncated () const
+  {
+    return !m_reason.empty ();
+  }
+
+  // Simulated seconds the run ended at: stopTime, or earlier if truncated
+  double GetEndTime (double stopTime) const
+  {
+    return IsTruncated () && m_stoppedAt < stopTime ? m_stoppedAt : stopTime;
+  }
+
+  void Report (std::ostream &os, RunResults &results)
+  {
+    if (IsTruncated ())
+      {
+        os << "Run truncated at " << m_stoppedAt << " s: " << m_reason << " budget exceeded after "
+           << m_progress.events << " events, " << m_progress.wallSeconds << " s wall, "
+           << m_progress.rssMiB << " MiB peak RSS\n";
+      }
+    else
+      {
+        Snapshot ();
+      }
+    results.Add ("truncated", IsTruncated () ? 1 : 0);
+    results.Add ("truncatedBy", IsTruncated () ? m_reason : "none");
+    results.Add ("stoppedAt", m_stoppedAt);
+  }
+
+private:
+  struct Progress
+  {
+    double time;          // simulated seconds
+    uint64_t events;
+    double wallSeconds;   // since Install ()
+    uint32_t rssMiB;      // peak
+  };
+
+  void Check ()
+  {
+    Snapshot ();
+    if (m_maxWallSeconds > 0 && m_progress.wallSeconds > m_maxWallSeconds)
+      {
+        m_reason = "wall";
+      }
+    else if (m_maxEvents > 0 && m_progress.events > m_maxEvents)
+      {
+        m_reason = "events";
+      }
+    else if (m_maxRssMiB > 0 && m_progress.rssMiB > m_maxRssMiB)
+      {
+        m_reason = "rss";
+      }
+    if (IsTruncated ())
+      {
+        m_stoppedAt = Simulator::Now ().GetSeconds ();
+        Snapshot ();   // flushes the progress file with the reason
+        Simulator::Stop ();
+        return;
+      }
+    Simulator::Schedule (Seconds (m_checkInterval), &RunBudget::Check, this);
+  }
+
+  // Records the progress so far and rewrites the --progress file
+  void Snapshot ()
+  {
+    m_progress.time = Simulator::Now ().GetSeconds ();
+    m_progress.events = Simulator::GetEventCount ();
+    m_progress.wallSeconds = WallClock () - m_start;
+    m_progress.rssMiB = PeakRssMiB ();
+    if (m_progressFile.empty ())
+      {
+        return;
+      }
+    std::ofstream out (m_progressFile.c_str ());
+    out << "time\t" << m_progress.time << "\n"
+        << "events\t" << m_progress.events << "\n"
+        << "wallSeconds\t" << m_progress.wallSeconds << "\n"
+        << "peakRssMiB\t" << m_progress.rssMiB << "\n"
+        << "truncatedBy\t" << (IsTruncated () ? m_reason : "none") << "\n";
+  }
+
+  static uint32_t PeakRssMiB ()
+  {
+    struct rusage usage;
+    getrusage (RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024;   // KiB on Linux
+  }
+
+  double m_maxWallSeconds;
+  uint64_t m_maxEvents;
+  uint32_t m_maxRssMiB;
+  double m_checkInterval;
+  double m_start;
+  double m_stoppedAt;       // simulated seconds, -1 if not truncated
+  std::string m_reason;
+  std::string m_progressFile;
+  Progress m_progress;      // as of the last check, or of Report () for a full run
+};
+
+} // namespace ns3
+
+#endif /* RUN_BUDGET_H */
@@ -0,0 +1,131 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef RUN_RESULTS_H
+#define RUN_RESULTS_H
+
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include "ns3/core-module.h"
+#include "results-store.h"
+#include "wall-clock.h"
+
+namespace ns3 {
+
+/*
+ * Machine readable results of one run, written by Report () to the
+ * --results file as "name<TAB>value" lines in the order they were added.
+ * sweep.cc passes --results to every run and joins the files into one
+ * table.  StartRun ()/StopRun () around Simulator::Run () add the wall
+ * time and executed event count.  With --store the same values, plus the
+ * RNG seed and run, the git revision of the working directory and the
+ * peak RSS, are appended as one row to a columnar results file (see
+ * results-store.h) that many runs can share.
+ */
+class RunResults
+{
+public:
+  RunResults ()
+    : m_start (0)
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("results", "Write the run results as name/value lines to this file", m_fileName);
+    cmd.AddValue ("store", "Append the run results as a row to this columnar results file", m_storeName);
+  }
+
+  void StartRun ()
+  {
+    m_start = WallClock ();
+  }
+
+  void StopRun ()
+  {
+    Add ("wallSeconds", WallClock () - m_start);
+    Add ("events", Simulator::GetEventCount ());
+  }
+
+  template <class T>
+  void Add (std::string name, const T &value)
+  {
+    std::ostringstream os;
+    os.precision (12);
+    os << value;
+    m_values.push_back (std::make_pair (name, os.str ()));
+  }
+
+  // Writes the --results file and the --store row, where given
+  void Write () const
+  {
+    if (!m_fileName.empty ())
+      {
+        std::ofstream out (m_fileName.c_str ());
+        for (uint32_t i = 0; i < m_values.size (); ++i)
+          {
+            out << m_values[i].first << "\t" << m_values[i].second << "\n";
+          }
+      }
+    if (!m_storeName.empty ())
+      {
+        RunResults row (*this);
+        row.Add ("seed", RngSeedManager::GetSeed ());
+        row.Add ("run", RngSeedManager::GetRun ());
+        row.Add ("gitRev", GitRevision ());
+        struct rusage usage;
+        getrusage (RUSAGE_SELF, &usage);
+        row.Add ("peakRssKiB", usage.ru_maxrss);
+        if (!ResultsStore::Append (m_storeName, row.m_values))
+          {
+            std::cout << "Cannot append to " << m_storeName << "\n";
+          }
+      }
+  }
+
+private:
+  static std::string GitRevision ()
+  {
+    std::string rev;
+    FILE *git = popen ("git rev-parse --short HEAD 2>/dev/null", "r");
+    if (git != 0)
+      {
+        char buf[64];
+        if (std::fgets (buf, sizeof (buf), git) != 0)
+          {
+            rev = buf;
+            rev.erase (rev.find_last_not_of ("\r\n") + 1);
+          }
+        pclose (git);
+      }
+    return rev.empty () ? "unknown" : rev;
+  }
+
+  std::string m_fileName;
+  std::string m_storeName;
+  double m_start;
+  std::vector<std::pair<std::string, std::string> > m_values;
+};
+
+} // namespace ns3
+
+#endif /* RUN_RESULTS_H */
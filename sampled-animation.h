@@ -0,0 +1,317 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SAMPLED_ANIMATION_H
+#define SAMPLED_ANIMATION_H
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/netanim-module.h"
+
+namespace ns3 {
+
+/*
+ * Animation output for the scratch scenarios, selected with --animMode:
+ *   none     no animation file at all
+ *   full     the stock AnimationInterface (every packet, every position)
+ *   sampled  a decimated NetAnim file written by this class
+ *
+ * In sampled mode positions are polled every --animPosInterval seconds and
+ * only written for nodes that moved more than --animMinMove meters since
+ * their last record.  Packets are kept when (uid % --animPktSample) == 0, so
+ * a sampled packet is followed over every hop; 0 disables packet records.
+ * --animNodes restricts the output to a node list such as "0-9,15".  A file
+ * name ending in ".gz" is streamed through an external gzip process.
+ */
+class SampledAnimation
+{
+public:
+  SampledAnimation (std::string mode, std::string fileName)
+    : m_mode (mode),
+      m_fileName (fileName),
+      m_posInterval (1.0),
+      m_minMove (1.0),
+      m_pktSample (100),
+      m_full (0),
+      m_file (0),
+      m_pipe (false),
+      m_posRecords (0),
+      m_pktRecords (0)
+  {
+  }
+
+  ~SampledAnimation ()
+  {
+    Close ();
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("animMode", "Animation output: none, full or sampled", m_mode);
+    cmd.AddValue ("animFile", "Animation file name (.gz streams through gzip)", m_fileName);
+    cmd.AddValue ("animPosInterval", "Sampled mode: position poll interval (s)", m_posInterval);
+    cmd.AddValue ("animMinMove", "Sampled mode: minimum movement (m) before a position is rewritten", m_minMove);
+    cmd.AddValue ("animPktSample", "Sampled mode: keep 1 in N packets, 0 for none", m_pktSample);
+    cmd.AddValue ("animNodes", "Sampled mode: node subset, e.g. 0-9,15 (empty for all)", m_nodes);
+  }
+
+  // Call once all nodes exist and before Simulator::Run ()
+  void Install ()
+  {
+    if (m_mode == "none")
+      {
+        return;
+      }
+    if (m_mode == "full")
+      {
+        m_full = new AnimationInterface (m_fileName);
+        return;
+      }
+    NS_ABORT_MSG_IF (m_mode != "sampled", "Unknown animMode " << m_mode);
+
+    Open ();
+    ParseNodes ();
+    std::fprintf (m_file, "<anim ver=\"netanim-3.105\" filetype=\"animation\" >\n");
+    m_last.resize (NodeList::GetNNodes ());
+    for (uint32_t i = 0; i < NodeList::GetNNodes (); ++i)
+      {
+        if (!Selected (i))
+          {
+            continue;
+          }
+        Vector pos = Position (i);
+        m_last[i] = pos;
+        std::fprintf (m_file, "<node id=\"%u\" sysId=\"0\" locX=\"%.2f\" locY=\"%.2f\" />\n", i, pos.x, pos.y);
+      }
+    Simulator::Schedule (Seconds (m_posInterval), &SampledAnimation::SamplePositions, this);
+
+    if (m_pktSample > 0)
+      {
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyTxBegin",
+                                       MakeCallback (&SampledAnimation::PhyTx, this));
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::WifiNetDevice/Phy/PhyRxEnd",
+                                       MakeCallback (&SampledAnimation::PhyRx, this));
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/PhyTxBegin",
+                                       MakeCallback (&SampledAnimation::PhyTx, this));
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::CsmaNetDevice/PhyRxEnd",
+                                       MakeCallback (&SampledAnimation::PhyRx, this));
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/PhyTxBegin",
+                                       MakeCallback (&SampledAnimation::PhyTx, this));
+        Config::ConnectWithoutContext ("/NodeList/*/DeviceList/*/$ns3::PointToPointNetDevice/PhyRxEnd",
+                                       MakeCallback (&SampledAnimation::PhyRx, this));
+      }
+  }
+
+  void Close ()
+  {
+    delete m_full;
+    m_full = 0;
+    if (m_file == 0)
+      {
+        return;
+      }
+    std::fprintf (m_file, "</anim>\n");
+    if (m_pipe)
+      {
+        pclose (m_file);
+      }
+    else
+      {
+        std::fclose (m_file);
+      }
+    m_file = 0;
+    std::cout << "Animation: " << m_posRecords << " position and " << m_pktRecords
+              << " packet records written to " << m_fileName << "\n";
+  }
+
+private:
+  struct TxRecord
+  {
+    uint32_t node;
+    double time;
+  };
+
+  SampledAnimation (const SampledAnimation &);
+  SampledAnimation &operator= (const SampledAnimation &);
+
+  void Open ()
+  {
+    std::string::size_type n = m_fileName.size ();
+    m_pipe = n > 3 && m_fileName.compare (n - 3, 3, ".gz") == 0;
+    if (m_pipe)
+      {
+        m_file = popen (("gzip -c > " + ShellQuote (m_fileName)).c_str (), "w");
+      }
+    else
+      {
+        m_file = std::fopen (m_fileName.c_str (), "w");
+      }
+    NS_ABORT_MSG_IF (m_file == 0, "Cannot open animation file " << m_fileName);
+    std::setvbuf (m_file, 0, _IOFBF, 1 << 16);
+  }
+
+  // One single-quoted shell word; embedded quotes become '\''
+  static std::string ShellQuote (const std::string &s)
+  {
+    std::string quoted = "'";
+    for (std::string::size_type i = 0; i < s.size (); ++i)
+      {
+        if (s[i] == '\'')
+          {
+            quoted += "'\\''";
+          }
+        else
+          {
+            quoted += s[i];
+          }
+      }
+    return quoted + "'";
+  }
+
+  // "0-9,15" -> m_selected; an empty list selects every node
+  void ParseNodes ()
+  {
+    m_selected.clear ();
+    if (m_nodes.empty ())
+      {
+        return;
+      }
+    m_selected.resize (NodeList::GetNNodes (), false);
+    std::istringstream in (m_nodes);
+    std::string item;
+    while (std::getline (in, item, ','))
+      {
+        uint32_t first = std::atoi (item.c_str ());
+        uint32_t last = first;
+        std::string::size_type dash = item.find ('-');
+        if (dash != std::string::npos)
+          {
+            last = std::atoi (item.c_str () + dash + 1);
+          }
+        for (uint32_t i = first; i <= last && i < m_selected.size (); ++i)
+          {
+            m_selected[i] = true;
+          }
+      }
+  }
+
+  bool Selected (uint32_t node) const
+  {
+    return m_selected.empty () || (node < m_selected.size () && m_selected[node]);
+  }
+
+  Vector Position (uint32_t node) const
+  {
+    Ptr<MobilityModel> mobility = NodeList::GetNode (node)->GetObject<MobilityModel> ();
+    return mobility ? mobility->GetPosition () : Vector ();
+  }
+
+  void SamplePositions ()
+  {
+    double now = Simulator::Now ().GetSeconds ();
+    for (uint32_t i = 0; i < m_last.size (); ++i)
+      {
+        if (!Selected (i))
+          {
+            continue;
+          }
+        Vector pos = Position (i);
+        if (CalculateDistance (pos, m_last[i]) < m_minMove)
+          {
+            continue;
+          }
+        m_last[i] = pos;
+        std::fprintf (m_file, "<nu p=\"p\" t=\"%.3f\" id=\"%u\" x=\"%.2f\" y=\"%.2f\" />\n", now, i, pos.x, pos.y);
+        ++m_posRecords;
+      }
+
+    // A transmission not received within a second never will be
+    std::map<uint64_t, TxRecord>::iterator it = m_tx.begin ();
+    while (it != m_tx.end ())
+      {
+        if (it->second.time < now - 1.0)
+          {
+            m_tx.erase (it++);
+          }
+        else
+          {
+            ++it;
+          }
+      }
+    Simulator::Schedule (Seconds (m_posInterval), &SampledAnimation::SamplePositions, this);
+  }
+
+  // Both PHY traces fire in the context of the node owning the device
+  void PhyTx (Ptr<const Packet> p)
+  {
+    uint64_t uid = p->GetUid ();
+    uint32_t node = Simulator::GetContext ();
+    if (uid % m_pktSample != 0 || !Selected (node))
+      {
+        return;
+      }
+    TxRecord &tx = m_tx[uid];
+    tx.node = node;
+    tx.time = Simulator::Now ().GetSeconds ();
+  }
+
+  void PhyRx (Ptr<const Packet> p)
+  {
+    uint64_t uid = p->GetUid ();
+    if (uid % m_pktSample != 0)
+      {
+        return;
+      }
+    std::map<uint64_t, TxRecord>::const_iterator it = m_tx.find (uid);
+    uint32_t node = Simulator::GetContext ();
+    if (it == m_tx.end () || it->second.node == node || !Selected (node))
+      {
+        return;
+      }
+    double now = Simulator::Now ().GetSeconds ();
+    std::fprintf (m_file, "<p fId=\"%u\" fbTx=\"%.6f\" lbTx=\"%.6f\" tId=\"%u\" fbRx=\"%.6f\" lbRx=\"%.6f\" />\n",
+                  it->second.node, it->second.time, it->second.time, node, now, now);
+    ++m_pktRecords;
+  }
+
+  std::string m_mode;
+  std::string m_fileName;
+  double m_posInterval;
+  double m_minMove;
+  uint32_t m_pktSample;
+  std::string m_nodes;
+
+  AnimationInterface *m_full;
+  FILE *m_file;
+  bool m_pipe;
+  std::vector<bool> m_selected;
+  std::vector<Vector> m_last;
+  std::map<uint64_t, TxRecord> m_tx;       // last sampled transmission of each packet uid
+  uint64_t m_posRecords;
+  uint64_t m_pktRecords;
+};
+
+} // namespace ns3
+
+#endif /* SAMPLED_ANIMATION_H */
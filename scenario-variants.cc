@@ -0,0 +1,906 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * The DGGFCompare scenario (AODV.cc, DGGF.cc, DSDV.cc, DSR.cc, OLSR.cc,
+ * SIFT.cc, compare.cc) as one program.  ScenarioVariant is templated on a
+ * routing and a mobility policy, so each variant constructs only the
+ * helpers of its own protocol and mobility model instead of all of them
+ * behind a switch.  Every combination is instantiated once and picked at
+ * run time:
+ *
+ * ./waf --run "scenario-variants --routing=AODV --mobility=RandomWaypoint"
+ *
+ * Routing: SIFT (alias DGGF), AODV, DSDV, DSR, OLSR.  Mobility:
+ * ConstantPosition, RandomDirection2, RandomWalk2, RandomWaypoint,
+ * GaussMarkov; --mobilityTrace replaces the model as in the copies.  The
+ * remaining options are those of the copies.  Report () adds the wall
+ * time of each setup phase and the size of this executable to the run
+ * results.
+ *
+ * ./waf --run "scenario-variants --compareWith=build/scratch"
+ *
+ * compares against the seven copies built in that directory: the size of
+ * each executable, and the wall time of a short run (process start, setup
+ * and the first 2 simulated seconds, no trace output) of each copy and of
+ * this program with the same protocol, best of --compareRepeat runs.  The
+ * runs are started in a temporary directory so that their output files
+ * do not clobber the current one.  The modules are shared libraries in the
+ * default build, so the sizes are those of the scenario code itself.
+ */
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/applications-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/wifi-module.h"
+#include "ns3/internet-module.h"
+#include "ns3/sift-module.h"
+#include "ns3/sift-helper.h"
+#include "ns3/sift-main-helper.h"
+#include "ns3/propagation-module.h"
+#include "ns3/aodv-module.h"
+#include "ns3/dsr-module.h"
+#include "ns3/dsdv-helper.h"
+#include "ns3/olsr-helper.h"
+#include "ns3/rng-seed-manager.h"
+#include "pcap-capture.h"
+#include "link-timeline.h"
+#include "event-scheduler.h"
+#include "packet-metadata.h"
+#include "memory-report.h"
+#include "compact-stack.h"
+#include "sampled-animation.h"
+#include "run-results.h"
+#include "run-budget.h"
+#include "traffic-replay.h"
+#include "path-tracer.h"
+#include "radio-energy.h"
+
+NS_LOG_COMPONENT_DEFINE ("ScenarioVariants");
+
+using namespace ns3;
+
+// Everything the variants share: parameters and the per-run helpers
+struct ScenarioConfig
+{
+  ScenarioConfig ();
+  bool Configure (int argc, char **argv);
+
+  uint32_t nNodes;       // # of wireless nodes
+  uint32_t nFlows;       // # of Sink nodes
+  double totalTime;      // Total simulation time
+  double dataTime;       // time to stop sending data
+  double ppers;          // Packets/Second
+  uint32_t packetSize;   // Packet size
+  double dataStartTime;  // time to start sending data
+  double nodePauseTime;  // Pause time between nodes movement
+  double nodeMaxSpeed;   // Node movement speed
+  double TxMaxRange;     // Wireless Transmission Range
+  std::string rate;
+  std::string dataMode;
+  std::string phyMode;
+  std::string routing;   // routing policy name
+  std::string mobility;  // mobility policy name
+  uint32_t SeedRun;
+  uint32_t SeedValue;
+  double xmax;           // x Length of Mobility area
+  double ymax;           // y Width of Mobility area
+  double zmax;           // z Height of Mobility Area
+  double xDelta;         // x delta b/t two consecutive nodes
+  double yDelta;         // y delta b/t two consectutive nodes
+  uint32_t periodicUpdateInterval;  // DSDV Parameter
+  uint32_t settlingTime;            // DSDV Parameter
+  std::string mobilityTrace;        // ns-2 trace replayed instead of the mobility policy
+  bool linkTimeline;                // answer RangePropagation from the precomputed timeline
+  std::string linkStats;            // prefix of the link/partition CSV export
+  std::string scheduler;            // event scheduler, see event-scheduler.h
+  std::string schedulerTrace;       // record scheduler operations for scheduler-bench
+  bool pcap;             // PCAP enable/disable
+  bool asciiTrace;       // wifi ascii trace to <protocol>.tr
+  std::string stack;     // internet stack profile, see compact-stack.h
+  std::string compareWith;          // directory of the seven copies, see CompareCopies ()
+  uint32_t compareRepeat;
+
+  PcapCapture capture;            // pcap filters, see pcap-capture.h
+  PacketMetadataLevel metadata;   // packet metadata/tags, see packet-metadata.h
+  MemoryReport memory;            // per node/layer memory, see memory-report.h
+  SampledAnimation anim;          // NetAnim output, see sampled-animation.h
+  RunResults results;             // Report () values for sweeps, see run-results.h
+  RunBudget budget;               // wall/event/RSS limits, see run-budget.h
+  TrafficReplay replay;           // trace-driven traffic, see traffic-replay.h
+  PathTracer paths;               // per-flow hop counts, see path-tracer.h
+  RadioEnergy energy;             // battery/radio energy, see radio-energy.h
+  LinkTimeline timeline;
+  double configureTime;           // wall time of Configure ()
+};
+
+ScenarioConfig::ScenarioConfig ()
+  : anim ("none", "SiftAnim.xml")
+{
+  nNodes = 30;
+  nFlows = 2;
+  totalTime = 1000;
+  ppers = 1;
+  packetSize = 64;
+  dataStartTime = 2.0;
+  nodePauseTime = 0;
+  nodeMaxSpeed = 20.0;
+  TxMaxRange = 250.0;
+  routing = "SIFT";
+  mobility = "RandomWaypoint";
+  xmax = 1500.0;
+  ymax = 300.0;
+  zmax = 1.0;
+  xDelta = 200;
+  yDelta = 200;
+  rate = ".512kbps";
+  dataMode = "DsssRate11Mbps";
+  phyMode = "DsssRate11Mbps";
+  SeedValue = 12345;
+  SeedRun = 54321;
+  periodicUpdateInterval = 15;
+  settlingTime = 6;
+  linkTimeline = false;
+  scheduler = "map";
+  pcap = false;
+  asciiTrace = true;
+  stack = "full";
+  compareRepeat = 3;
+  configureTime = 0;
+}
+
+bool
+ScenarioConfig::Configure (int argc, char **argv)
+{
+  double start = WallClock ();
+  CommandLine cmd;
+
+  cmd.AddValue ("routing", "Routing protocol: SIFT (DGGF), AODV, DSDV, DSR or OLSR, Default:SIFT", routing);
+  cmd.AddValue ("mobility", "Mobility model: ConstantPosition, RandomDirection2, RandomWalk2, RandomWaypoint or GaussMarkov", mobility);
+  cmd.AddValue ("SeedValue", "Specify a new seed for the run.  Default:12345", SeedValue);
+  cmd.AddValue ("SeedRun", "Run index (for setting repeatable seeds)", SeedRun);
+  cmd.AddValue ("nNodes", "Number of wifi nodes", nNodes);
+  cmd.AddValue ("nFlows", "Number of SINK traffic nodes", nFlows);
+  cmd.AddValue ("totalTime", "Set the total simulation run time", totalTime);
+  cmd.AddValue ("packetSize", "The packet size", packetSize);
+  cmd.AddValue ("nodePauseTime", "Specify node max pause time, Default:0" , nodePauseTime);
+  cmd.AddValue ("nodeMaxSpeed", "Node speed in RandomWayPoint model, Default:20", nodeMaxSpeed);
+  cmd.AddValue ("TxMaxRange", "Specify node's transmit range, Default:250", TxMaxRange);
+  cmd.AddValue ("xmax", "Specify Simulation Area Length, Default:1500", xmax);
+  cmd.AddValue ("ymax", "Specify Simulation Area Width, Default:300", ymax);
+  cmd.AddValue ("zmax", "Specify Simulation Area Height, Default:1.0", zmax);
+  cmd.AddValue ("xDelta", "Specify starting position x spacing, Default:200", xDelta);
+  cmd.AddValue ("yDelta", "Specify starting position y spacing, Default:200", yDelta);
+  cmd.AddValue ("rate", "CBR traffic rate(in kbps), Default:8", rate);
+  cmd.AddValue ("mobilityTrace", "Replay an ns-2 mobility trace instead of the mobility model", mobilityTrace);
+  cmd.AddValue ("linkTimeline", "Use the link timeline of mobilityTrace instead of per-frame distances, Default:false", linkTimeline);
+  cmd.AddValue ("linkStats", "Write link durations and partitions of mobilityTrace to <prefix>-*.csv", linkStats);
+  cmd.AddValue ("scheduler", "Event scheduler: map, heap, list, calendar or quadheap, Default:map", scheduler);
+  cmd.AddValue ("schedulerTrace", "Record scheduler operations to this file for scheduler-bench", schedulerTrace);
+  cmd.AddValue ("pcap", "Enable pcap capture, Default:false", pcap);
+  capture.AddCommandLine (cmd);
+  cmd.AddValue ("asciiTrace", "Write the wifi ascii trace, Default:true", asciiTrace);
+  metadata.AddCommandLine (cmd);
+  memory.AddCommandLine (cmd);
+  cmd.AddValue ("stack", "Internet stack: full or compact (IPv4/UDP only), Default:full", stack);
+  anim.AddCommandLine (cmd);
+  results.AddCommandLine (cmd);
+  budget.AddCommandLine (cmd);
+  replay.AddCommandLine (cmd);
+  paths.AddCommandLine (cmd);
+  energy.AddCommandLine (cmd);
+  cmd.AddValue ("compareWith", "Compare size and startup with the seven copies built in this directory", compareWith);
+  cmd.AddValue ("compareRepeat", "Runs per program in --compareWith, the fastest counts, Default:3", compareRepeat);
+  cmd.Parse (argc, argv);
+
+  // After Parse, so that --SeedValue/--SeedRun and --totalTime take effect
+  RngSeedManager::SetSeed (SeedValue);
+  RngSeedManager::SetRun (SeedRun);
+  dataTime = totalTime - totalTime * .01;
+
+  if (linkTimeline && mobilityTrace.empty ())
+    {
+      std::cout << "linkTimeline needs a mobilityTrace\n";
+      return false;
+    }
+  if (stack != "full" && stack != "compact")
+    {
+      std::cout << "Unknown stack " << stack << "\n";
+      return false;
+    }
+  if (!metadata.Resolve (asciiTrace, false))
+    {
+      std::cout << "Unknown packetMetadata level\n";
+      return false;
+    }
+  if (!SelectScheduler (scheduler, schedulerTrace))
+    {
+      std::cout << "Unknown scheduler " << scheduler << "\n";
+      return false;
+    }
+  if (!budget.IsValid ())
+    {
+      std::cout << "budgetCheck must be a positive number of seconds\n";
+      return false;
+    }
+  if (!replay.Open ())
+    {
+      std::cout << "Cannot read traffic trace\n";
+      return false;
+    }
+  configureTime = WallClock () - start;
+  return true;
+}
+
+// Mobility policies: Install () sets the position allocator and model
+
+static std::string
+UniformString (double min, double max)
+{
+  std::ostringstream os;
+  os << "ns3::UniformRandomVariable[Min=" << min << "|Max=" << max << "]";
+  return os.str ();
+}
+
+static std::string
+ConstantString (double value)
+{
+  std::ostringstream os;
+  os << "ns3::ConstantRandomVariable[Constant=" << value << "]";
+  return os.str ();
+}
+
+static void
+SetGridAllocator (MobilityHelper &mobility, const ScenarioConfig &c)
+{
+  mobility.SetPositionAllocator ("ns3::GridPositionAllocator",
+                                 "MinX", DoubleValue (0.0),
+                                 "MinY", DoubleValue (0.0),
+                                 "DeltaX", DoubleValue (c.xDelta),
+                                 "DeltaY", DoubleValue (c.yDelta),
+                                 "GridWidth", UintegerValue (c.xmax / c.xDelta),
+                                 "LayoutType", StringValue ("RowFirst"));
+}
+
+struct ConstantPosition
+{
+  static const char *Name () { return "ConstantPosition"; }
+  static void Install (MobilityHelper &mobility, const ScenarioConfig &c)
+  {
+    SetGridAllocator (mobility, c);
+    mobility.SetMobilityModel ("ns3::ConstantPositionMobilityModel");
+  }
+};
+
+struct RandomDirection2
+{
+  static const char *Name () { return "RandomDirection2"; }
+  static void Install (MobilityHelper &mobility, const ScenarioConfig &c)
+  {
+    SetGridAllocator (mobility, c);
+    mobility.SetMobilityModel ("ns3::RandomDirection2MobilityModel",
+                               "Pause", StringValue (ConstantString (c.nodePauseTime)),
+                               "Speed", StringValue (UniformString (16, c.nodeMaxSpeed)),
+                               "Bounds", RectangleValue (Rectangle (0.0, c.xmax, 0.0, c.ymax)));
+  }
+};
+
+struct RandomWalk2
+{
+  static const char *Name () { return "RandomWalk2"; }
+  static void Install (MobilityHelper &mobility, const ScenarioConfig &c)
+  {
+    SetGridAllocator (mobility, c);
+    mobility.SetMobilityModel ("ns3::RandomWalk2MobilityModel",
+                               "Mode", StringValue ("Time"),
+                               "Time", TimeValue (Seconds (c.nodePauseTime > 0 ? c.nodePauseTime : 1.0)),
+                               "Speed", StringValue (UniformString (16, c.nodeMaxSpeed)),
+                               "Bounds", RectangleValue (Rectangle (0.0, c.xmax, 0.0, c.ymax)));
+  }
+};
+
+struct RandomWaypoint
+{
+  static const char *Name () { return "RandomWaypoint"; }
+  static void Install (MobilityHelper &mobility, const ScenarioConfig &c)
+  {
+    int64_t streamIndex = 0; // used to get consistent mobility across scenarios
+    ObjectFactory pos;
+    pos.SetTypeId ("ns3::RandomBoxPositionAllocator");
+    pos.Set ("X", StringValue (UniformString (0.0, c.xmax)));
+    pos.Set ("Y", StringValue (UniformString (0.0, c.ymax)));
+    pos.Set ("Z", StringValue (UniformString (0.0, c.zmax)));
+    Ptr<PositionAllocator> taPositionAlloc = pos.Create ()->GetObject<PositionAllocator> ();
+    streamIndex += taPositionAlloc->AssignStreams (streamIndex);
+    mobility.SetMobilityModel ("ns3::RandomWaypointMobilityModel",
+                               "Speed", StringValue (UniformString (16, c.nodeMaxSpeed)),
+                               "Pause", StringValue (ConstantString (c.nodePauseTime)),
+                               "PositionAllocator", PointerValue (taPositionAlloc));
+    mobility.SetPositionAllocator (taPositionAlloc);
+  }
+};
+
+struct GaussMarkov
+{
+  static const char *Name () { return "GaussMarkov"; }
+  static void Install (MobilityHelper &mobility, const ScenarioConfig &c)
+  {
+    mobility.SetPositionAllocator ("ns3::RandomBoxPositionAllocator",
+                                   "X", StringValue (UniformString (0.0, c.xmax)),
+                                   "Y", StringValue (UniformString (0.0, c.ymax)),
+                                   "Z", StringValue (UniformString (0.0, c.zmax)));
+    mobility.SetMobilityModel ("ns3::GaussMarkovMobilityModel",
+                               "Bounds", BoxValue (Box (0, c.xmax, 0, c.ymax, 0, c.zmax)),
+                               "Pause", StringValue (ConstantString (c.nodePauseTime)),
+                               "MeanVelocity", StringValue (UniformString (16, c.nodeMaxSpeed)));
+  }
+};
+
+// Routing policies: Install () puts the stack and protocol on the nodes
+
+struct SiftRouting
+{
+  static const char *Name () { return "SIFT"; }
+  static const char *TraceName () { return "sift"; }
+  static void Install (CompactStackHelper &internet, NodeContainer &nodes, const ScenarioConfig &c)
+  {
+    SiftMainHelper siftMain;
+    SiftHelper sift;
+    internet.Install (nodes);
+    sift.SetNodes (nodes);
+    siftMain.Install (sift, nodes);
+  }
+};
+
+struct AodvRouting
+{
+  static const char *Name () { return "AODV"; }
+  static const char *TraceName () { return "aodv"; }
+  static void Install (CompactStackHelper &internet, NodeContainer &nodes, const ScenarioConfig &c)
+  {
+    AodvHelper aodv;
+    internet.SetRoutingHelper (aodv);
+    internet.Install (nodes);
+  }
+};
+
+struct DsdvRouting
+{
+  static const char *Name () { return "DSDV"; }
+  static const char *TraceName () { return "dsdv"; }
+  static void Install (CompactStackHelper &internet, NodeContainer &nodes, const ScenarioConfig &c)
+  {
+    DsdvHelper dsdv;
+    dsdv.Set ("PeriodicUpdateInterval", TimeValue (Seconds (c.periodicUpdateInterval)));
+    dsdv.Set ("SettlingTime", TimeValue (Seconds (c.settlingTime)));
+    internet.SetRoutingHelper (dsdv);     // has effect on the next Install ()
+    internet.Install (nodes);
+  }
+};
+
+struct DsrRouting
+{
+  static const char *Name () { return "DSR"; }
+  static const char *TraceName () { return "dsr"; }
+  static void Install (CompactStackHelper &internet, NodeContainer &nodes, const ScenarioConfig &c)
+  {
+    DsrMainHelper dsrMain;
+    DsrHelper dsr;
+    internet.Install (nodes);
+    dsrMain.Install (dsr, nodes);
+  }
+};
+
+struct OlsrRouting
+{
+  static const char *Name () { return "OLSR"; }
+  static const char *TraceName () { return "olsr"; }
+  static void Install (CompactStackHelper &internet, NodeContainer &nodes, const ScenarioConfig &c)
+  {
+    OlsrHelper olsr;
+    Ipv4StaticRoutingHelper staticRouting;
+    Ipv4ListRoutingHelper list;
+    list.Add (staticRouting, 0);
+    list.Add (olsr, 10);
+    internet.SetRoutingHelper (list);
+    internet.Install (nodes);
+  }
+};
+
+template <class Routing, class Mobility>
+class ScenarioVariant
+{
+public:
+  ScenarioVariant (ScenarioConfig &config)
+    : c (config),
+      rxPackets (0)
+  {
+  }
+
+  void Run ();
+  void Report (std::ostream &os);
+
+private:
+  ScenarioConfig &c;
+  NodeContainer mobileNodes;
+  NetDeviceContainer allDevices;
+  Ipv4InterfaceContainer allInterfaces;
+  ApplicationContainer sinks;
+  uint64_t rxPackets;               // counted by SinkRx, sizes vary with trafficTrace
+  std::vector<std::pair<std::string, double> > phases;   // setup phase, wall seconds
+
+  void CreateNodes ();
+  void CreateDevices ();
+  void InstallInternetStack ();
+  void InstallApplications ();
+  void SinkRx (Ptr<const Packet> packet, const Address &from);
+};
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::Run ()
+{
+  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", UintegerValue (1)); // enable rts cts all the time.
+  phases.push_back (std::make_pair ("configure", c.configureTime));
+  double start = WallClock ();
+  CreateNodes ();
+  if (!c.mobilityTrace.empty () && (c.linkTimeline || !c.linkStats.empty ()))
+    {
+      c.timeline.Build (c.mobilityTrace, c.nNodes, c.TxMaxRange, c.totalTime);
+      if (!c.linkStats.empty ())
+        {
+          c.timeline.WriteStats (c.linkStats);
+        }
+    }
+  phases.push_back (std::make_pair ("nodes", WallClock () - start));
+  start = WallClock ();
+  CreateDevices ();
+  phases.push_back (std::make_pair ("devices", WallClock () - start));
+  start = WallClock ();
+  InstallInternetStack ();
+  phases.push_back (std::make_pair ("stack", WallClock () - start));
+  start = WallClock ();
+  InstallApplications ();
+  for (uint32_t i = 0; i < sinks.GetN (); ++i)
+    {
+      sinks.Get (i)->TraceConnectWithoutContext ("Rx", MakeCallback (&ScenarioVariant::SinkRx, this));
+    }
+  phases.push_back (std::make_pair ("applications", WallClock () - start));
+  c.energy.Install (mobileNodes, allDevices, c.totalTime);
+
+  std::cout << "Starting " << Routing::Name () << "/" << Mobility::Name () << " simulation for "
+            << c.totalTime << " s ...\n";
+  Simulator::Stop (Seconds (c.totalTime));
+  c.anim.Install ();
+  c.metadata.StartCost ();
+  c.memory.Install ();
+  c.results.StartRun ();
+  c.budget.Install ();
+  c.paths.Install ();
+  Simulator::Run ();
+  c.results.StopRun ();
+  c.metadata.StopCost ();
+  c.memory.Finish ();
+  c.energy.Finish ();
+  c.anim.Close ();
+  Simulator::Destroy ();
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::Report (std::ostream &os)
+{
+  if (c.timeline.IsBuilt ())
+    {
+      c.timeline.Report (os);
+    }
+  c.metadata.ReportCost (os);
+  c.memory.Report (os);
+
+  double setup = 0;
+  os << "Setup:";
+  for (uint32_t i = 0; i < phases.size (); ++i)
+    {
+      os << " " << phases[i].first << " " << phases[i].second << " s";
+      c.results.Add ("setup_" + phases[i].first, phases[i].second);
+      setup += phases[i].second;
+    }
+  struct stat st;
+  off_t binaryBytes = stat ("/proc/self/exe", &st) == 0 ? st.st_size : 0;
+  os << ", total " << setup << " s; binary " << binaryBytes << " bytes\n";
+
+  uint64_t rxBytes = 0;
+  for (uint32_t i = 0; i < sinks.GetN (); ++i)
+    {
+      rxBytes += DynamicCast<PacketSink> (sinks.Get (i))->GetTotalRx ();
+    }
+  os << "Delivered " << rxBytes << " bytes to " << sinks.GetN () << " sinks\n";
+  c.results.Add ("routing", std::string (Routing::Name ()));
+  c.results.Add ("mobility", std::string (Mobility::Name ()));
+  c.results.Add ("nNodes", c.nNodes);
+  c.results.Add ("totalTime", c.totalTime);
+  c.results.Add ("nFlows", c.nFlows);
+  c.results.Add ("packetSize", c.packetSize);
+  c.results.Add ("rate", c.rate);
+  c.results.Add ("nodeMaxSpeed", c.nodeMaxSpeed);
+  c.results.Add ("nodePauseTime", c.nodePauseTime);
+  c.results.Add ("TxMaxRange", c.TxMaxRange);
+  c.results.Add ("xmax", c.xmax);
+  c.results.Add ("ymax", c.ymax);
+  c.results.Add ("rxBytes", rxBytes);
+  // data flows from dataStartTime to dataTime, unless a budget stopped the run first
+  double dataSeconds = c.budget.GetEndTime (c.dataTime) - c.dataStartTime;
+  c.results.Add ("rxPackets", rxPackets);
+  c.results.Add ("throughputKbps", dataSeconds > 0 ? rxBytes * 8.0 / 1000 / dataSeconds : 0);
+  c.results.Add ("setupSeconds", setup);
+  c.results.Add ("binaryBytes", (uint64_t) binaryBytes);
+  c.energy.Report (os, c.results, rxBytes);
+  c.paths.Report (os, c.results);
+  c.replay.Report (os, c.results);
+  c.budget.Report (os, c.results);
+  c.results.Write ();
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::CreateNodes ()
+{
+  std::cout << "Creating " << (unsigned)c.nNodes << " Nodes.\n";
+  mobileNodes.Create (c.nNodes);
+  for (uint32_t i = 0; i < c.nNodes; ++i)  // This will name the mobile nodes consecutive numbers
+    {
+      std::ostringstream os;
+      os << "node-" << i;
+      Names::Add (os.str (), mobileNodes.Get (i));
+    }
+  if (!c.mobilityTrace.empty ())
+    {
+      Ns2MobilityHelper ns2 (c.mobilityTrace);
+      ns2.Install ();
+      return;
+    }
+  MobilityHelper mobility;
+  Mobility::Install (mobility, c);
+  mobility.Install (mobileNodes);
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::CreateDevices ()
+{
+  Config::SetDefault ("ns3::WifiRemoteStationManager::NonUnicastMode", StringValue (c.phyMode));
+  Config::SetDefault ("ns3::WifiRemoteStationManager::RtsCtsThreshold", StringValue ("2200"));
+  // disable fragmentation for frames below 2200 bytes
+  Config::SetDefault ("ns3::WifiRemoteStationManager::FragmentationThreshold", StringValue ("2200"));
+
+  WifiHelper wifi;
+  wifi.SetStandard (WIFI_PHY_STANDARD_80211b);
+  YansWifiPhyHelper wifiPhy = YansWifiPhyHelper::Default ();
+
+  if (c.linkTimeline)
+    {
+      // Same connectivity as RangePropagationLossModel, looked up instead of computed per frame
+      Ptr<LinkTimelineLossModel> lossModel = CreateObject<LinkTimelineLossModel> ();
+      lossModel->SetTimeline (&c.timeline);
+      Ptr<YansWifiChannel> channel = CreateObject<YansWifiChannel> ();
+      channel->SetPropagationDelayModel (CreateObject<ConstantSpeedPropagationDelayModel> ());
+      channel->SetPropagationLossModel (lossModel);
+      wifiPhy.SetChannel (channel);
+    }
+  else
+    {
+      YansWifiChannelHelper wifiChannel;
+      wifiChannel.SetPropagationDelay ("ns3::ConstantSpeedPropagationDelayModel");
+      wifiChannel.AddPropagationLoss ("ns3::RangePropagationLossModel", "MaxRange", DoubleValue (c.TxMaxRange));
+      wifiPhy.SetChannel (wifiChannel.Create ());
+    }
+  // Add a non-QoS upper mac, and disable rate control
+  NqosWifiMacHelper wifiMac = NqosWifiMacHelper::Default ();
+  wifi.SetRemoteStationManager ("ns3::ConstantRateWifiManager", "DataMode", StringValue (c.dataMode), "ControlMode",
+                                StringValue (c.phyMode));
+
+  wifiMac.SetType ("ns3::AdhocWifiMac");
+  allDevices = wifi.Install (wifiPhy, wifiMac, mobileNodes);
+
+  if (c.pcap)
+    {
+      c.capture.Install (wifiPhy, std::string (Routing::TraceName ()) + "pcap", allDevices);
+    }
+  if (c.metadata.AllowsAscii ())
+    {
+      AsciiTraceHelper ascii;
+      wifiPhy.EnableAsciiAll (ascii.CreateFileStream (std::string (Routing::TraceName ()) + ".tr"));
+    }
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::InstallInternetStack ()
+{
+  CompactStackHelper internet (c.stack == "compact");
+  Routing::Install (internet, mobileNodes, c);
+
+  Ipv4AddressHelper address;
+  address.SetBase ("10.1.1.0", "255.255.255.0");
+  allInterfaces = address.Assign (allDevices);
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::SinkRx (Ptr<const Packet> packet, const Address &from)
+{
+  ++rxPackets;
+}
+
+template <class Routing, class Mobility>
+void
+ScenarioVariant<Routing, Mobility>::InstallApplications ()
+{
+  uint16_t port = 9;
+  if (c.replay.IsEnabled ())
+    {
+      // a sink on every node, the trace decides who talks to whom
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      sinks = sink.Install (mobileNodes);
+      sinks.Start (Seconds (0.0));
+      sinks.Stop (Seconds (c.totalTime - 1));
+      c.replay.Install (mobileNodes, allInterfaces, Seconds (c.dataStartTime));
+      return;
+    }
+  double randomStartTime = (1 / c.ppers) / c.nFlows;
+  for (uint32_t i = 0; i < c.nFlows; ++i)
+    {
+      PacketSinkHelper sink ("ns3::UdpSocketFactory", InetSocketAddress (Ipv4Address::GetAny (), port));
+      ApplicationContainer apps_sink = sink.Install (mobileNodes.Get (i));
+      sinks.Add (apps_sink);
+      apps_sink.Start (Seconds (0.0));
+      apps_sink.Stop (Seconds (c.totalTime - 1));
+      OnOffHelper onoff1 ("ns3::UdpSocketFactory", Address (InetSocketAddress (allInterfaces.GetAddress (i), port)));
+      onoff1.SetAttribute ("OnTime", StringValue ("ns3::ConstantRandomVariable[Constant=1.0]"));
+      onoff1.SetAttribute ("OffTime", StringValue ("ns3::ConstantRandomVariable[Constant=0.0]"));
+      onoff1.SetAttribute ("PacketSize", UintegerValue (c.packetSize));
+      onoff1.SetAttribute ("DataRate", DataRateValue (DataRate (c.rate)));
+      ApplicationContainer apps1 = onoff1.Install (mobileNodes.Get (i + c.nNodes - c.nFlows));
+      apps1.Start (Seconds (c.dataStartTime + i * randomStartTime));
+      apps1.Stop (Seconds (c.dataTime + i * randomStartTime));
+    }
+}
+
+// The run-time table of all instantiated combinations
+
+typedef void (*VariantMain) (ScenarioConfig &config, std::ostream &os);
+
+struct VariantEntry
+{
+  std::string routing;
+  std::string mobility;
+  VariantMain main;
+};
+
+template <class Routing, class Mobility>
+static void
+RunVariant (ScenarioConfig &config, std::ostream &os)
+{
+  ScenarioVariant<Routing, Mobility> variant (config);
+  variant.Run ();
+  variant.Report (os);
+}
+
+template <class Routing, class Mobility>
+static void
+AddVariant (std::vector<VariantEntry> &table)
+{
+  VariantEntry e;
+  e.routing = Routing::Name ();
+  e.mobility = Mobility::Name ();
+  e.main = &RunVariant<Routing, Mobility>;
+  table.push_back (e);
+}
+
+template <class Routing>
+static void
+AddRouting (std::vector<VariantEntry> &table)
+{
+  AddVariant<Routing, ConstantPosition> (table);
+  AddVariant<Routing, RandomDirection2> (table);
+  AddVariant<Routing, RandomWalk2> (table);
+  AddVariant<Routing, RandomWaypoint> (table);
+  AddVariant<Routing, GaussMarkov> (table);
+}
+
+static std::vector<VariantEntry>
+Variants ()
+{
+  std::vector<VariantEntry> table;
+  AddRouting<SiftRouting> (table);
+  AddRouting<AodvRouting> (table);
+  AddRouting<DsdvRouting> (table);
+  AddRouting<DsrRouting> (table);
+  AddRouting<OlsrRouting> (table);
+  return table;
+}
+
+// Wall time of one run of args in dir with its output discarded, -1 if it failed
+static double
+TimeRun (const std::vector<std::string> &args, std::string dir)
+{
+  double start = WallClock ();
+  pid_t pid = fork ();
+  if (pid < 0)
+    {
+      std::perror ("fork");
+      return -1;
+    }
+  if (pid == 0)
+    {
+      int null = open ("/dev/null", O_WRONLY);
+      if (null >= 0)
+        {
+          dup2 (null, 1);
+          dup2 (null, 2);
+          close (null);
+        }
+      if (chdir (dir.c_str ()) != 0)
+        {
+          _exit (127);
+        }
+      std::vector<char *> argv;
+      for (uint32_t i = 0; i < args.size (); ++i)
+        {
+          argv.push_back (const_cast<char *> (args[i].c_str ()));
+        }
+      argv.push_back (0);
+      execv (argv[0], &argv[0]);
+      _exit (127);
+    }
+  int status;
+  while (waitpid (pid, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+  if (!WIFEXITED (status) || WEXITSTATUS (status) != 0)
+    {
+      return -1;
+    }
+  return WallClock () - start;
+}
+
+static double
+BestRun (const std::vector<std::string> &args, std::string dir, uint32_t repeat)
+{
+  double best = -1;
+  for (uint32_t i = 0; i < repeat; ++i)
+    {
+      double t = TimeRun (args, dir);
+      if (t < 0)
+        {
+          return -1;
+        }
+      best = best < 0 || t < best ? t : best;
+    }
+  return best;
+}
+
+static bool
+CompareCopies (const ScenarioConfig &c)
+{
+  struct Copy
+  {
+    const char *program;
+    const char *routing;
+    const char *caveat;   // where the copy does not run what the variant runs
+  };
+  // The routing protocol each copy runs by default
+  const Copy copies[] = {
+    { "AODV", "AODV", 0 }, { "DGGF", "SIFT", 0 }, { "DSDV", "DSDV", 0 }, { "DSR", "DSR", 0 },
+    { "OLSR", "OLSR", "OLSR.cc adds its list routing to itself instead of olsr, so the copy runs no OLSR" },
+    { "SIFT", "SIFT", 0 }, { "compare", "SIFT", 0 }
+  };
+  char self[PATH_MAX];
+  ssize_t n = readlink ("/proc/self/exe", self, sizeof (self) - 1);
+  char dir[PATH_MAX];
+  if (n < 0 || realpath (c.compareWith.c_str (), dir) == 0)
+    {
+      std::cout << "Cannot resolve " << c.compareWith << " or this executable\n";
+      return false;
+    }
+  self[n] = '\0';
+  char tmp[] = "/tmp/scenario-variants-XXXXXX";
+  if (mkdtemp (tmp) == 0)
+    {
+      std::perror ("mkdtemp");
+      return false;
+    }
+
+  // A short run: setup plus the first 2 simulated seconds, no traces
+  std::vector<std::string> common;
+  common.push_back ("--totalTime=2");
+  common.push_back ("--asciiTrace=false");
+
+  struct stat st;
+  off_t selfBytes = stat (self, &st) == 0 ? st.st_size : 0;
+  off_t copiesBytes = 0;
+  std::cout << std::left << std::setw (10) << "program" << std::right << std::setw (12) << "bytes"
+            << std::setw (12) << "startup s" << std::setw (14) << "variant s" << "\n";
+  for (uint32_t i = 0; i < sizeof (copies) / sizeof (copies[0]); ++i)
+    {
+      std::string path = std::string (dir) + "/" + copies[i].program;
+      if (stat (path.c_str (), &st) != 0)
+        {
+          std::cout << std::left << std::setw (10) << copies[i].program << " not built in " << dir << "\n";
+          continue;
+        }
+      copiesBytes += st.st_size;
+      std::vector<std::string> copyArgs (1, path);
+      copyArgs.insert (copyArgs.end (), common.begin (), common.end ());
+      std::vector<std::string> selfArgs (1, std::string (self));
+      selfArgs.push_back (std::string ("--routing=") + copies[i].routing);
+      selfArgs.insert (selfArgs.end (), common.begin (), common.end ());
+      double copyTime = BestRun (copyArgs, tmp, c.compareRepeat);
+      double selfTime = BestRun (selfArgs, tmp, c.compareRepeat);
+      std::cout << std::left << std::setw (10) << copies[i].program << std::right << std::setw (12) << st.st_size
+                << std::fixed << std::setprecision (3) << std::setw (12) << copyTime << std::setw (14) << selfTime
+                << "\n";
+      if (copies[i].caveat != 0)
+        {
+          std::cout << "  not like for like: " << copies[i].caveat << "\n";
+        }
+    }
+  std::cout << "Copies: " << copiesBytes << " bytes in total; scenario-variants: " << selfBytes << " bytes for "
+            << Variants ().size () << " variants\n";
+  std::cout << "Run output left in " << tmp << "\n";
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  ScenarioConfig config;
+  if (!config.Configure (argc, argv))
+    {
+      std::cout << "Configuration failed.\n";
+      exit (1);
+    }
+  if (!config.compareWith.empty ())
+    {
+      return CompareCopies (config) ? 0 : 1;
+    }
+
+  std::string routing = config.routing == "DGGF" ? "SIFT" : config.routing;
+  std::vector<VariantEntry> table = Variants ();
+  for (uint32_t i = 0; i < table.size (); ++i)
+    {
+      if (table[i].routing == routing && table[i].mobility == config.mobility)
+        {
+          table[i].main (config, std::cout);
+          return 0;
+        }
+    }
+  std::cout << "No variant for routing " << config.routing << " and mobility " << config.mobility << "\n";
+  return 1;
+}
@@ -0,0 +1,250 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Event scheduler benchmark.
+ *
+ * Replays a scheduler trace recorded by one of the routing scenarios,
+ *
+ * ./waf --run "OLSR --nNodes=300 --totalTime=100 --schedulerTrace=olsr.sched"
+ * ./waf --run "scheduler-bench --trace=olsr.sched"
+ *
+ * against each scheduler of --schedulers and reports three rates:
+ *   replay  the recorded Insert/RemoveNext/Remove sequence, as run
+ *   insert  filling an empty scheduler up to the peak queue size of the
+ *           trace, with event times drawn from the recorded delays
+ *   remove  draining that queue again with RemoveNext
+ * Without --trace a synthetic hold model is used: --events queued events,
+ * --ops remove/insert pairs, a --timerFraction share of the new events are
+ * periodic routing timers (1-2 s ahead) and the rest MAC/PHY events
+ * (exponential, 1 ms mean).  The list scheduler is O(n) per insert and is
+ * left out of the default set; add it by name for small queues.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "event-scheduler.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+struct BenchResult
+{
+  double replayMops;
+  double insertMops;
+  double removeMops;
+};
+
+static bool
+ReadTrace (std::string fileName, std::vector<EventTraceRecord> &trace)
+{
+  FILE *file = std::fopen (fileName.c_str (), "rb");
+  if (file == 0)
+    {
+      return false;
+    }
+  EventTraceRecord r;
+  while (std::fread (&r, sizeof (r), 1, file) == 1)
+    {
+      trace.push_back (r);
+    }
+  std::fclose (file);
+  return true;
+}
+
+static EventTraceRecord
+Insert (uint64_t delay, uint32_t uid)
+{
+  EventTraceRecord r;
+  r.delay = delay;
+  r.uid = uid;
+  r.op = EventTraceRecord::INSERT;
+  return r;
+}
+
+/// Hold model with a mix of routing timers and MAC/PHY events, delays in ns
+static void
+Synthesize (uint32_t events, uint32_t ops, double timerFraction, std::vector<EventTraceRecord> &trace)
+{
+  uint32_t uid = 0;
+  for (uint32_t i = 0; i < events + ops; ++i)
+    {
+      double u = (std::rand () + 1.0) / (RAND_MAX + 2.0);
+      uint64_t delay;
+      if (std::rand () < timerFraction * RAND_MAX)
+        {
+          delay = uint64_t ((1.0 + u) * 1e9);
+        }
+      else
+        {
+          delay = uint64_t (-std::log (u) * 1e6);
+        }
+      if (i >= events)
+        {
+          EventTraceRecord next = { 0, 0, EventTraceRecord::REMOVE_NEXT };
+          trace.push_back (next);
+        }
+      trace.push_back (Insert (delay, uid++));
+    }
+}
+
+static Scheduler::Event
+MakeEvent (uint64_t ts, uint32_t uid)
+{
+  Scheduler::Event ev;
+  ev.impl = 0;
+  ev.key.m_ts = ts;
+  ev.key.m_uid = uid;
+  ev.key.m_context = 0;
+  return ev;
+}
+
+/// Largest number of events queued at once while replaying \p trace
+static uint32_t
+PeakSize (const std::vector<EventTraceRecord> &trace)
+{
+  uint32_t size = 0;
+  uint32_t peak = 0;
+  for (uint32_t i = 0; i < trace.size (); ++i)
+    {
+      if (trace[i].op == EventTraceRecord::INSERT)
+        {
+          peak = std::max (peak, ++size);
+        }
+      else if (size > 0)
+        {
+          --size;
+        }
+    }
+  return peak;
+}
+
+static BenchResult
+Bench (std::string type, const std::vector<EventTraceRecord> &trace, uint32_t peak)
+{
+  BenchResult result;
+  ObjectFactory factory;
+  factory.SetTypeId (type);
+
+  Ptr<Scheduler> scheduler = factory.Create<Scheduler> ();
+  uint64_t now = 0;
+  double start = WallClock ();
+  for (uint32_t i = 0; i < trace.size (); ++i)
+    {
+      const EventTraceRecord &r = trace[i];
+      switch (r.op)
+        {
+        case EventTraceRecord::INSERT:
+          scheduler->Insert (MakeEvent (now + r.delay, r.uid));
+          break;
+        case EventTraceRecord::REMOVE_NEXT:
+          now = scheduler->RemoveNext ().key.m_ts;
+          break;
+        case EventTraceRecord::REMOVE:
+          scheduler->Remove (MakeEvent (now + r.delay, r.uid));
+          break;
+        }
+    }
+  result.replayMops = trace.size () / (WallClock () - start) / 1e6;
+
+  scheduler = factory.Create<Scheduler> ();
+  uint32_t n = 0;
+  start = WallClock ();
+  for (uint32_t i = 0; i < trace.size () && n < peak; ++i)
+    {
+      if (trace[i].op == EventTraceRecord::INSERT)
+        {
+          scheduler->Insert (MakeEvent (trace[i].delay, n++));
+        }
+    }
+  result.insertMops = n / (WallClock () - start) / 1e6;
+
+  start = WallClock ();
+  while (!scheduler->IsEmpty ())
+    {
+      scheduler->RemoveNext ();
+    }
+  result.removeMops = n / (WallClock () - start) / 1e6;
+  return result;
+}
+
+int main (int argc, char **argv)
+{
+  std::string traceFile;
+  std::string schedulers = "map,heap,calendar,quadheap";
+  uint32_t events = 100000;
+  uint32_t ops = 1000000;
+  double timerFraction = 0.1;
+  uint32_t seed = 1;
+
+  CommandLine cmd;
+  cmd.AddValue ("trace", "Scheduler trace written by --schedulerTrace", traceFile);
+  cmd.AddValue ("schedulers", "Schedulers to compare: map, heap, list, calendar, quadheap", schedulers);
+  cmd.AddValue ("events", "Synthetic: events queued at once", events);
+  cmd.AddValue ("ops", "Synthetic: remove/insert pairs", ops);
+  cmd.AddValue ("timerFraction", "Synthetic: share of routing timers among new events", timerFraction);
+  cmd.AddValue ("seed", "Synthetic: random seed", seed);
+  cmd.Parse (argc, argv);
+
+  std::vector<EventTraceRecord> trace;
+  if (traceFile.empty ())
+    {
+      std::srand (seed);
+      Synthesize (events, ops, timerFraction, trace);
+      std::cout << "Synthetic hold model: ";
+    }
+  else if (!ReadTrace (traceFile, trace))
+    {
+      std::cout << "Cannot read " << traceFile << "\n";
+      return 1;
+    }
+  else
+    {
+      std::cout << traceFile << ": ";
+    }
+  uint32_t peak = PeakSize (trace);
+  std::cout << trace.size () << " operations, peak queue " << peak << " events\n";
+
+  std::cout << std::left << std::setw (12) << "scheduler"
+            << std::right << std::setw (16) << "replay Mops/s"
+            << std::setw (16) << "insert Mops/s"
+            << std::setw (16) << "remove Mops/s" << "\n";
+  std::istringstream names (schedulers);
+  std::string name;
+  while (std::getline (names, name, ','))
+    {
+      std::string type = SchedulerTypeName (name);
+      if (type.empty ())
+        {
+          std::cout << "Unknown scheduler " << name << "\n";
+          return 1;
+        }
+      BenchResult r = Bench (type, trace, peak);
+      std::cout << std::left << std::setw (12) << name << std::right << std::fixed << std::setprecision (3)
+                << std::setw (16) << r.replayMops
+                << std::setw (16) << r.insertMops
+                << std::setw (16) << r.removeMops << "\n";
+    }
+  return 0;
+}
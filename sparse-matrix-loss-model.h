@@ -0,0 +1,274 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef SPARSE_MATRIX_LOSS_MODEL_H
+#define SPARSE_MATRIX_LOSS_MODEL_H
+
+#include <algorithm>
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/mobility-module.h"
+#include "ns3/propagation-module.h"
+
+namespace ns3 {
+
+/*
+ * Loss matrix keyed by node id instead of MobilityModel pointer pairs, for
+ * measured topologies with thousands of nodes where most pairs have no link.
+ *
+ * Losses are staged with SetLoss () / LoadFile () and packed on first use
+ * into a CSR layout: m_rowStart[a] .. m_rowStart[a + 1] is the slice of
+ * m_slots owned by transmitter a.  Each slice is a small open-addressed
+ * table (power of two, at most half full) keyed by receiver id, so a lookup
+ * is one row offset plus an expected O(1) probe.  A slot costs 16 bytes and
+ * absent pairs cost nothing; they return the default loss.
+ *
+ * Losses are kept in double precision, as MatrixPropagationLossModel does.
+ *
+ * LoadFile () reads "tx rx lossDb" lines; '#' starts a comment.  Like
+ * SetLoss (), it applies each loss in both directions unless told not to.
+ */
+class SparseMatrixLossModel : public PropagationLossModel
+{
+public:
+  static TypeId GetTypeId (void)
+  {
+    static TypeId tid = TypeId ("ns3::SparseMatrixLossModel")
+      .SetParent (PropagationLossModel::GetTypeId ())
+      .AddConstructor<SparseMatrixLossModel> ();
+    return tid;
+  }
+
+  SparseMatrixLossModel ()
+    : m_default (std::numeric_limits<double>::max ()),
+      m_dirty (false)
+  {
+  }
+
+  void SetDefaultLoss (double defaultLoss)
+  {
+    m_default = defaultLoss;
+  }
+
+  void SetLoss (uint32_t a, uint32_t b, double loss, bool symmetric = true)
+  {
+    Entry e = { a, b, loss, uint32_t (m_staged.size () + 1) };
+    m_staged.push_back (e);
+    if (symmetric)
+      {
+        Entry r = { b, a, loss, uint32_t (m_staged.size () + 1) };
+        m_staged.push_back (r);
+      }
+    m_dirty = true;
+  }
+
+  // Same signature as MatrixPropagationLossModel::SetLoss
+  void SetLoss (Ptr<MobilityModel> a, Ptr<MobilityModel> b, double loss, bool symmetric = true)
+  {
+    SetLoss (a->GetObject<Node> ()->GetId (), b->GetObject<Node> ()->GetId (), loss, symmetric);
+  }
+
+  // Returns the number of links read
+  uint32_t LoadFile (std::string fileName, bool symmetric = true)
+  {
+    std::ifstream in (fileName.c_str ());
+    NS_ABORT_MSG_IF (!in.is_open (), "Cannot open loss matrix " << fileName);
+    std::string line;
+    uint32_t links = 0;
+    while (std::getline (in, line))
+      {
+        std::string::size_type comment = line.find ('#');
+        if (comment != std::string::npos)
+          {
+            line.erase (comment);
+          }
+        std::istringstream fields (line);
+        uint32_t a, b;
+        double loss;
+        if (fields >> a >> b >> loss)
+          {
+            SetLoss (a, b, loss, symmetric);
+            ++links;
+          }
+      }
+    return links;
+  }
+
+  double GetLoss (uint32_t a, uint32_t b) const
+  {
+    if (m_dirty)
+      {
+        Pack ();
+      }
+    if (a + 1 >= m_rowStart.size ())
+      {
+        return m_default;
+      }
+    uint32_t start = m_rowStart[a];
+    uint32_t mask = m_rowStart[a + 1] - start - 1;
+    if (mask + 1 == 0)
+      {
+        return m_default;
+      }
+    for (uint32_t h = Hash (b) & mask; ; h = (h + 1) & mask)
+      {
+        const Slot &s = m_slots[start + h];
+        if (s.rx == b)
+          {
+            return s.loss;
+          }
+        if (s.rx == EMPTY)
+          {
+            return m_default;
+          }
+      }
+  }
+
+  // Bytes held by the packed matrix
+  uint64_t GetMemoryBytes () const
+  {
+    return m_rowStart.capacity () * sizeof (uint32_t) + m_slots.capacity () * sizeof (Slot);
+  }
+
+private:
+  static const uint32_t EMPTY = 0xffffffff;
+
+  struct Entry
+  {
+    uint32_t tx;
+    uint32_t rx;
+    double loss;
+    uint32_t order;   // later SetLoss () calls win; 0 for already packed entries
+  };
+
+  struct Slot
+  {
+    uint32_t rx;
+    double loss;
+  };
+
+  static bool ByPair (const Entry &l, const Entry &r)
+  {
+    if (l.tx != r.tx)
+      {
+        return l.tx < r.tx;
+      }
+    if (l.rx != r.rx)
+      {
+        return l.rx < r.rx;
+      }
+    return l.order < r.order;
+  }
+
+  static uint32_t Hash (uint32_t id)
+  {
+    uint32_t h = id * 2654435761u;
+    return h ^ (h >> 16);
+  }
+
+  void Pack () const
+  {
+    std::vector<Entry> all;
+    for (uint32_t a = 0; a + 1 < m_rowStart.size (); ++a)
+      {
+        for (uint32_t k = m_rowStart[a]; k < m_rowStart[a + 1]; ++k)
+          {
+            if (m_slots[k].rx != EMPTY)
+              {
+                Entry e = { a, m_slots[k].rx, m_slots[k].loss, 0 };
+                all.push_back (e);
+              }
+          }
+      }
+    all.insert (all.end (), m_staged.begin (), m_staged.end ());
+    std::vector<Entry> ().swap (m_staged);
+    std::sort (all.begin (), all.end (), ByPair);
+
+    // keep the last entry of each (tx, rx)
+    std::vector<Entry> unique;
+    for (uint32_t i = 0; i < all.size (); ++i)
+      {
+        if (i + 1 < all.size () && all[i + 1].tx == all[i].tx && all[i + 1].rx == all[i].rx)
+          {
+            continue;
+          }
+        unique.push_back (all[i]);
+      }
+
+    uint32_t rows = unique.empty () ? 0 : unique.back ().tx + 1;
+    std::vector<uint32_t> degree (rows, 0);
+    for (uint32_t i = 0; i < unique.size (); ++i)
+      {
+        ++degree[unique[i].tx];
+      }
+    m_rowStart.assign (rows + 1, 0);
+    for (uint32_t a = 0; a < rows; ++a)
+      {
+        uint32_t capacity = 0;
+        if (degree[a] > 0)
+          {
+            capacity = 2;
+            while (capacity < 2 * degree[a])
+              {
+                capacity *= 2;
+              }
+          }
+        m_rowStart[a + 1] = m_rowStart[a] + capacity;
+      }
+    Slot empty = { EMPTY, 0 };
+    m_slots.assign (m_rowStart[rows], empty);
+    for (uint32_t i = 0; i < unique.size (); ++i)
+      {
+        uint32_t start = m_rowStart[unique[i].tx];
+        uint32_t mask = m_rowStart[unique[i].tx + 1] - start - 1;
+        uint32_t h = Hash (unique[i].rx) & mask;
+        while (m_slots[start + h].rx != EMPTY)
+          {
+            h = (h + 1) & mask;
+          }
+        m_slots[start + h].rx = unique[i].rx;
+        m_slots[start + h].loss = unique[i].loss;
+      }
+    m_dirty = false;
+  }
+
+  virtual double DoCalcRxPower (double txPowerDbm, Ptr<MobilityModel> a, Ptr<MobilityModel> b) const
+  {
+    return txPowerDbm - GetLoss (a->GetObject<Node> ()->GetId (), b->GetObject<Node> ()->GetId ());
+  }
+
+  virtual int64_t DoAssignStreams (int64_t stream)
+  {
+    return 0;
+  }
+
+  double m_default;
+  mutable bool m_dirty;
+  mutable std::vector<Entry> m_staged;
+  mutable std::vector<uint32_t> m_rowStart;
+  mutable std::vector<Slot> m_slots;
+};
+
+NS_OBJECT_ENSURE_REGISTERED (SparseMatrixLossModel);
+
+} // namespace ns3
+
+#endif /* SPARSE_MATRIX_LOSS_MODEL_H */
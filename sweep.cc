@@ -0,0 +1,516 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Parameter sweep over one of the routing scenarios.
+ *
+ * ./waf --run "sweep --spec=aodv.sweep --out=aodv-sweep --workers=8"
+ *
+ * The spec file names the program and the parameter ranges, one per line:
+ *
+ *   # AODV against node count and mobility
+ *   command = build/scratch/AODV --asciiTrace=false --maxWallSeconds=1800
+ *   nNodes = 50, 100, 200
+ *   nodeMaxSpeed nodePauseTime = 1 0, 5 10, 20 30
+ *   SeedRun = 1:10
+ *
+ * Every line is one axis of a Cartesian product.  A line with several
+ * names is zipped: each comma separated entry gives one value per name,
+ * so the line above is three (speed, pause) points, not nine.  a:b and
+ * a:b:step expand to a numeric range.  The example is 3 x 3 x 10 = 90
+ * runs.
+ *
+ * Each run gets its values as --name=value options plus --results and
+ * --store, and its output goes to <out>/run-<id>.log.  Runs are started on --workers
+ * processes (default: all cores), longest first by nNodes x totalTime,
+ * taken from the point, the command or the DGGFCompare defaults (30 nodes,
+ * 1000 s).  Every finished run is appended to <out>/checkpoint.tsv, and a
+ * sweep started again with the same --out skips the runs that completed
+ * there.  At the end the results files of all runs are joined into
+ * <out>/results.tsv: one row per run, the swept values, exit status and
+ * wall time, then every value the runs' Report () wrote.  The runs also
+ * append their results with run metadata to <out>/results.rcs, which
+ * results-query reads column by column.
+ *
+ * Budgets such as --maxWallSeconds belong on the command line; a run that
+ * exceeds one stops itself and is stored as truncated.  --killAfter is a
+ * backstop that kills runs which overrun even so, e.g. a run whose
+ * simulated clock no longer advances; those fail with status 137.
+ */
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+struct Axis
+{
+  std::vector<std::string> names;
+  std::vector<std::vector<std::string> > values;   // [entry][name]
+};
+
+struct SweepPoint
+{
+  uint32_t id;
+  std::vector<std::pair<std::string, std::string> > params;
+  std::string label;
+  double cost;
+  int status;
+  double wallSeconds;
+  bool done;
+};
+
+static std::string
+Trim (const std::string &s)
+{
+  std::string::size_type b = s.find_first_not_of (" \t\r");
+  std::string::size_type e = s.find_last_not_of (" \t\r");
+  return b == std::string::npos ? "" : s.substr (b, e - b + 1);
+}
+
+static std::vector<std::string>
+Split (const std::string &s, char sep)
+{
+  std::vector<std::string> out;
+  std::istringstream in (s);
+  std::string item;
+  if (sep == ' ')
+    {
+      while (in >> item)
+        {
+          out.push_back (item);
+        }
+      return out;
+    }
+  while (std::getline (in, item, sep))
+    {
+      out.push_back (Trim (item));
+    }
+  return out;
+}
+
+static bool
+ParseNumber (const std::string &s, double &v)
+{
+  char *end;
+  v = std::strtod (s.c_str (), &end);
+  return !s.empty () && *end == '\0';
+}
+
+// a:b or a:b:step; false if text is not a numeric range
+static bool
+ExpandRange (const std::string &text, std::vector<std::string> &out)
+{
+  std::vector<std::string> parts = Split (text, ':');
+  double from, to, step = 1;
+  if (parts.size () < 2 || parts.size () > 3 || !ParseNumber (parts[0], from) || !ParseNumber (parts[1], to)
+      || (parts.size () == 3 && (!ParseNumber (parts[2], step) || step <= 0)))
+    {
+      return false;
+    }
+  for (uint32_t k = 0; from + k * step <= to + step * 1e-9; ++k)
+    {
+      std::ostringstream os;
+      os << from + k * step;
+      out.push_back (os.str ());
+    }
+  return true;
+}
+
+static bool
+ReadSpec (std::string fileName, std::string &command, std::vector<Axis> &axes)
+{
+  std::ifstream in (fileName.c_str ());
+  if (!in)
+    {
+      std::cout << "Cannot read " << fileName << "\n";
+      return false;
+    }
+  std::string line;
+  for (uint32_t n = 1; std::getline (in, line); ++n)
+    {
+      line = Trim (line.substr (0, line.find ('#')));
+      if (line.empty ())
+        {
+          continue;
+        }
+      std::string::size_type eq = line.find ('=');
+      if (eq == std::string::npos)
+        {
+          std::cout << fileName << ":" << n << ": expected name = values\n";
+          return false;
+        }
+      std::string left = Trim (line.substr (0, eq));
+      std::string right = Trim (line.substr (eq + 1));
+      if (left == "command")
+        {
+          command = right;
+          continue;
+        }
+      Axis axis;
+      axis.names = Split (left, ' ');
+      std::vector<std::string> entries = Split (right, ',');
+      for (uint32_t e = 0; e < entries.size (); ++e)
+        {
+          std::vector<std::string> tuple = Split (entries[e], ' ');
+          std::vector<std::string> range;
+          if (axis.names.size () == 1 && tuple.size () == 1 && ExpandRange (tuple[0], range))
+            {
+              for (uint32_t r = 0; r < range.size (); ++r)
+                {
+                  axis.values.push_back (std::vector<std::string> (1, range[r]));
+                }
+              continue;
+            }
+          if (tuple.size () != axis.names.size ())
+            {
+              std::cout << fileName << ":" << n << ": '" << entries[e] << "' needs "
+                        << axis.names.size () << " values\n";
+              return false;
+            }
+          axis.values.push_back (tuple);
+        }
+      if (axis.names.empty () || axis.values.empty ())
+        {
+          std::cout << fileName << ":" << n << ": empty axis\n";
+          return false;
+        }
+      axes.push_back (axis);
+    }
+  if (command.empty ())
+    {
+      std::cout << fileName << ": no command\n";
+      return false;
+    }
+  return true;
+}
+
+// Value of --name=value in the point or the command, else def
+static double
+CostFactor (const SweepPoint &p, const std::vector<std::string> &command, std::string name, double def)
+{
+  double v;
+  for (uint32_t i = 0; i < p.params.size (); ++i)
+    {
+      if (p.params[i].first == name && ParseNumber (p.params[i].second, v))
+        {
+          return v;
+        }
+    }
+  std::string prefix = "--" + name + "=";
+  for (uint32_t i = 0; i < command.size (); ++i)
+    {
+      if (command[i].compare (0, prefix.size (), prefix) == 0 && ParseNumber (command[i].substr (prefix.size ()), v))
+        {
+          return v;
+        }
+    }
+  return def;
+}
+
+static std::vector<SweepPoint>
+Expand (const std::vector<Axis> &axes, const std::vector<std::string> &command)
+{
+  std::vector<SweepPoint> points;
+  std::vector<uint32_t> index (axes.size (), 0);
+  while (true)
+    {
+      SweepPoint p;
+      p.id = points.size ();
+      for (uint32_t a = 0; a < axes.size (); ++a)
+        {
+          for (uint32_t k = 0; k < axes[a].names.size (); ++k)
+            {
+              p.params.push_back (std::make_pair (axes[a].names[k], axes[a].values[index[a]][k]));
+              p.label += (p.label.empty () ? "" : " ") + axes[a].names[k] + "=" + axes[a].values[index[a]][k];
+            }
+        }
+      p.cost = CostFactor (p, command, "nNodes", 30) * CostFactor (p, command, "totalTime", 1000);
+      p.status = -1;
+      p.wallSeconds = 0;
+      p.done = false;
+      points.push_back (p);
+
+      // odometer over the axes, the last one fastest
+      int a = axes.size () - 1;
+      while (a >= 0 && ++index[a] == axes[a].values.size ())
+        {
+          index[a--] = 0;
+        }
+      if (a < 0)
+        {
+          return points;
+        }
+    }
+}
+
+static std::string
+RunFile (std::string out, uint32_t id, std::string suffix)
+{
+  std::ostringstream os;
+  os << out << "/run-" << id << suffix;
+  return os.str ();
+}
+
+static pid_t
+Launch (const SweepPoint &p, const std::vector<std::string> &command, std::string out)
+{
+  std::vector<std::string> args (command);
+  for (uint32_t i = 0; i < p.params.size (); ++i)
+    {
+      args.push_back ("--" + p.params[i].first + "=" + p.params[i].second);
+    }
+  args.push_back ("--results=" + RunFile (out, p.id, ".results"));
+  args.push_back ("--store=" + out + "/results.rcs");
+
+  pid_t pid = fork ();
+  if (pid != 0)
+    {
+      return pid;
+    }
+  int log = open (RunFile (out, p.id, ".log").c_str (), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (log >= 0)
+    {
+      dup2 (log, 1);
+      dup2 (log, 2);
+      close (log);
+    }
+  std::vector<char *> argv;
+  for (uint32_t i = 0; i < args.size (); ++i)
+    {
+      argv.push_back (const_cast<char *> (args[i].c_str ()));
+    }
+  argv.push_back (0);
+  execvp (argv[0], &argv[0]);
+  std::perror (argv[0]);
+  _exit (127);
+}
+
+static bool
+LongerFirst (const SweepPoint *a, const SweepPoint *b)
+{
+  return a->cost > b->cost;
+}
+
+static void
+ReadCheckpoint (std::string fileName, std::vector<SweepPoint> &points)
+{
+  std::map<std::string, SweepPoint *> byLabel;
+  for (uint32_t i = 0; i < points.size (); ++i)
+    {
+      byLabel[points[i].label] = &points[i];
+    }
+  std::ifstream in (fileName.c_str ());
+  std::string line;
+  while (std::getline (in, line))
+    {
+      std::vector<std::string> f = Split (line, '\t');
+      if (f.size () == 4 && byLabel.count (f[3]) && std::atoi (f[1].c_str ()) == 0)
+        {
+          SweepPoint *p = byLabel[f[3]];
+          p->done = true;
+          p->status = 0;
+          p->wallSeconds = std::atof (f[2].c_str ());
+        }
+    }
+}
+
+static void
+WriteTable (std::string fileName, std::string out, const std::vector<SweepPoint> &points)
+{
+  std::vector<std::string> keys;
+  std::vector<std::map<std::string, std::string> > values (points.size ());
+  for (uint32_t i = 0; i < points.size (); ++i)
+    {
+      std::ifstream in (RunFile (out, points[i].id, ".results").c_str ());
+      std::string line;
+      while (std::getline (in, line))
+        {
+          std::string::size_type tab = line.find ('\t');
+          if (tab == std::string::npos)
+            {
+              continue;
+            }
+          std::string key = line.substr (0, tab);
+          bool swept = false;
+          for (uint32_t k = 0; k < points[i].params.size (); ++k)
+            {
+              swept = swept || points[i].params[k].first == key;
+            }
+          if (!swept && std::find (keys.begin (), keys.end (), key) == keys.end ())
+            {
+              keys.push_back (key);
+            }
+          values[i][key] = line.substr (tab + 1);
+        }
+    }
+
+  std::ofstream os (fileName.c_str ());
+  os << "run";
+  for (uint32_t k = 0; points.size () > 0 && k < points[0].params.size (); ++k)
+    {
+      os << "\t" << points[0].params[k].first;
+    }
+  os << "\tstatus\trunSeconds";
+  for (uint32_t k = 0; k < keys.size (); ++k)
+    {
+      os << "\t" << keys[k];
+    }
+  os << "\n";
+  for (uint32_t i = 0; i < points.size (); ++i)
+    {
+      os << points[i].id;
+      for (uint32_t k = 0; k < points[i].params.size (); ++k)
+        {
+          os << "\t" << points[i].params[k].second;
+        }
+      os << "\t" << points[i].status << "\t" << points[i].wallSeconds;
+      for (uint32_t k = 0; k < keys.size (); ++k)
+        {
+          std::map<std::string, std::string>::const_iterator v = values[i].find (keys[k]);
+          os << "\t" << (v == values[i].end () ? "" : v->second);
+        }
+      os << "\n";
+    }
+}
+
+int main (int argc, char **argv)
+{
+  std::string spec;
+  std::string out = "sweep";
+  uint32_t workers = 0;
+  bool dryRun = false;
+  double killAfter = 0;
+
+  CommandLine cmd;
+  cmd.AddValue ("spec", "Sweep specification file", spec);
+  cmd.AddValue ("out", "Directory for logs, checkpoint and results.tsv", out);
+  cmd.AddValue ("workers", "Runs at a time, 0 for one per core", workers);
+  cmd.AddValue ("dryRun", "Only print the runs in the order they would start", dryRun);
+  cmd.AddValue ("killAfter", "Kill runs still going after this many wall seconds, 0 never", killAfter);
+  cmd.Parse (argc, argv);
+
+  std::string command;
+  std::vector<Axis> axes;
+  if (spec.empty () || !ReadSpec (spec, command, axes))
+    {
+      std::cout << "Usage: sweep --spec=<file> [--out=<dir>] [--workers=N]\n";
+      return 1;
+    }
+  std::vector<std::string> commandArgs = Split (command, ' ');
+  std::vector<SweepPoint> points = Expand (axes, commandArgs);
+  if (workers == 0)
+    {
+      workers = std::max<long> (1, sysconf (_SC_NPROCESSORS_ONLN));
+    }
+  if (mkdir (out.c_str (), 0755) != 0 && errno != EEXIST)
+    {
+      std::perror (out.c_str ());
+      return 1;
+    }
+  std::string checkpointFile = out + "/checkpoint.tsv";
+  ReadCheckpoint (checkpointFile, points);
+
+  std::vector<SweepPoint *> queue;
+  for (uint32_t i = 0; i < points.size (); ++i)
+    {
+      if (!points[i].done)
+        {
+          queue.push_back (&points[i]);
+        }
+    }
+  std::stable_sort (queue.begin (), queue.end (), LongerFirst);
+  std::cout << "Sweep: " << points.size () << " runs, " << points.size () - queue.size ()
+            << " already done, " << workers << " workers\n";
+  if (dryRun)
+    {
+      for (uint32_t i = 0; i < queue.size (); ++i)
+        {
+          std::cout << "  run-" << queue[i]->id << "  cost " << queue[i]->cost << "  " << queue[i]->label << "\n";
+        }
+      return 0;
+    }
+
+  std::ofstream checkpoint (checkpointFile.c_str (), std::ios::app);
+  std::map<pid_t, std::pair<SweepPoint *, double> > running;
+  uint32_t next = 0, finished = 0, failed = 0;
+  double start = WallClock ();
+  while (next < queue.size () || !running.empty ())
+    {
+      while (next < queue.size () && running.size () < workers)
+        {
+          pid_t pid = Launch (*queue[next], commandArgs, out);
+          if (pid < 0)
+            {
+              std::perror ("fork");
+              break;
+            }
+          running[pid] = std::make_pair (queue[next++], WallClock ());
+        }
+      int status;
+      pid_t pid = killAfter > 0 ? waitpid (-1, &status, WNOHANG) : wait (&status);
+      if (pid == 0)
+        {
+          // backstop for runs whose own --maxWallSeconds check never fires
+          for (std::map<pid_t, std::pair<SweepPoint *, double> >::iterator r = running.begin (); r != running.end (); ++r)
+            {
+              if (WallClock () - r->second.second > killAfter)
+                {
+                  kill (r->first, SIGKILL);
+                }
+            }
+          usleep (200000);
+          continue;
+        }
+      if (pid < 0)
+        {
+          break;
+        }
+      if (running.count (pid) == 0)
+        {
+          continue;
+        }
+      SweepPoint *p = running[pid].first;
+      p->wallSeconds = WallClock () - running[pid].second;
+      p->status = WIFEXITED (status) ? WEXITSTATUS (status) : 128 + WTERMSIG (status);
+      running.erase (pid);
+      failed += p->status != 0;
+      checkpoint << p->id << "\t" << p->status << "\t" << p->wallSeconds << "\t" << p->label << std::endl;
+      std::cout << "[" << ++finished << "/" << queue.size () << "] run-" << p->id << " " << p->label
+                << ": " << (p->status == 0 ? "ok" : "FAILED") << " in " << p->wallSeconds << " s\n";
+    }
+
+  std::string table = out + "/results.tsv";
+  WriteTable (table, out, points);
+  std::cout << "Sweep finished in " << WallClock () - start << " s, " << failed << " failed; results in "
+            << table << "\n";
+  return failed == 0 ? 0 : 1;
+}
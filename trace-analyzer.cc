@@ -0,0 +1,468 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Summarises the ASCII trace written by wifiPhy.EnableAsciiAll () in the
+ * routing scenarios (AODV.tr, dsrp.tr, olsr.tr, ...).
+ *
+ * ./waf --run "trace-analyzer --trace=aodv.tr --perNode=aodv-nodes.tsv --perSecond=aodv-seconds.tsv"
+ *
+ * The trace is mapped and cut into --threads chunks at line boundaries
+ * (default: all cores); each thread counts its chunk into its own tables,
+ * which are added up at the end.  Lines and the fields inside them are
+ * found with SSE2 byte compares, 16 bytes at a time, where the compiler
+ * targets it; --scalar forces the byte loop instead, for comparison.
+ *
+ * Per node: frames transmitted (t), received (r) and dropped (d), DATA
+ * frames transmitted, how many of those were MAC retransmissions
+ * (Retry=1) and the payload bytes sent and received.  Per second of
+ * simulated time: payload bytes transmitted and received.  Receptions are
+ * PHY receptions, so frames overheard by neighbours count as well.
+ * --check runs the scan twice, scalar on one thread and as configured,
+ * and compares the tables.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "ns3/core-module.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+// Lines naming a larger node id or simulated second are skipped, not counted
+static const uint64_t MAX_NODE_ID = 1 << 20;
+static const uint64_t MAX_SECOND = 1 << 22;
+
+struct NodeCounts
+{
+  NodeCounts ()
+    : tx (0), rx (0), drop (0), txData (0), retries (0), txBytes (0), rxBytes (0)
+  {
+  }
+
+  uint64_t tx;
+  uint64_t rx;
+  uint64_t drop;
+  uint64_t txData;    // DATA frames transmitted
+  uint64_t retries;   // of which retransmissions
+  uint64_t txBytes;   // payload
+  uint64_t rxBytes;
+};
+
+struct SecondCounts
+{
+  SecondCounts ()
+    : txBytes (0), rxBytes (0)
+  {
+  }
+
+  uint64_t txBytes;
+  uint64_t rxBytes;
+};
+
+// What one thread found in its chunk
+struct TraceCounts
+{
+  TraceCounts ()
+    : lines (0), skipped (0)
+  {
+  }
+
+  void Add (const TraceCounts &o);
+  bool operator== (const TraceCounts &o) const;
+
+  uint64_t lines;
+  uint64_t skipped;   // lines that are not t/r/d records of a node, or out of range
+  std::vector<NodeCounts> nodes;
+  std::vector<SecondCounts> seconds;
+};
+
+void
+TraceCounts::Add (const TraceCounts &o)
+{
+  lines += o.lines;
+  skipped += o.skipped;
+  nodes.resize (std::max (nodes.size (), o.nodes.size ()));
+  for (uint32_t i = 0; i < o.nodes.size (); ++i)
+    {
+      nodes[i].tx += o.nodes[i].tx;
+      nodes[i].rx += o.nodes[i].rx;
+      nodes[i].drop += o.nodes[i].drop;
+      nodes[i].txData += o.nodes[i].txData;
+      nodes[i].retries += o.nodes[i].retries;
+      nodes[i].txBytes += o.nodes[i].txBytes;
+      nodes[i].rxBytes += o.nodes[i].rxBytes;
+    }
+  seconds.resize (std::max (seconds.size (), o.seconds.size ()));
+  for (uint32_t i = 0; i < o.seconds.size (); ++i)
+    {
+      seconds[i].txBytes += o.seconds[i].txBytes;
+      seconds[i].rxBytes += o.seconds[i].rxBytes;
+    }
+}
+
+bool
+TraceCounts::operator== (const TraceCounts &o) const
+{
+  if (lines != o.lines || skipped != o.skipped || nodes.size () != o.nodes.size ()
+      || seconds.size () != o.seconds.size ())
+    {
+      return false;
+    }
+  for (uint32_t i = 0; i < nodes.size (); ++i)
+    {
+      if (std::memcmp (&nodes[i], &o.nodes[i], sizeof (NodeCounts)) != 0)
+        {
+          return false;
+        }
+    }
+  for (uint32_t i = 0; i < seconds.size (); ++i)
+    {
+      if (std::memcmp (&seconds[i], &o.seconds[i], sizeof (SecondCounts)) != 0)
+        {
+          return false;
+        }
+    }
+  return true;
+}
+
+// First c in [p, end), or end
+static const char *
+FindChar (const char *p, const char *end, char c, bool simd)
+{
+#ifdef __SSE2__
+  if (simd)
+    {
+      const __m128i needle = _mm_set1_epi8 (c);
+      for (; p + 16 <= end; p += 16)
+        {
+          int mask = _mm_movemask_epi8 (_mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) p), needle));
+          if (mask != 0)
+            {
+              return p + __builtin_ctz (mask);
+            }
+        }
+    }
+#endif
+  for (; p < end && *p != c; ++p)
+    {
+    }
+  return p;
+}
+
+// Start of the first occurrence of pattern in [p, end), or end
+static const char *
+Find (const char *p, const char *end, const char *pattern, bool simd)
+{
+  size_t n = std::strlen (pattern);
+  for (p = FindChar (p, end, pattern[0], simd); p + n <= end; p = FindChar (p + 1, end, pattern[0], simd))
+    {
+      if (std::memcmp (p, pattern, n) == 0)
+        {
+          return p;
+        }
+    }
+  return end;
+}
+
+static uint64_t
+ParseUnsigned (const char *&p, const char *end)
+{
+  uint64_t v = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p)
+    {
+      v = v * 10 + (*p - '0');
+    }
+  return v;
+}
+
+/*
+ * One trace line, e.g.
+ * t 1.5001 /NodeList/3/DeviceList/0/$ns3::WifiNetDevice/Phy/State/Tx DsssRate11Mbps ...
+ *   ns3::WifiMacHeader (DATA ToDS=0, FromDS=0, MoreFrag=0, Retry=1, ...) ... Payload (size=64) ...
+ */
+static void
+CountLine (const char *p, const char *end, bool simd, TraceCounts &counts)
+{
+  ++counts.lines;
+  char op = *p;
+  if (end - p < 4 || (op != 't' && op != 'r' && op != 'd') || p[1] != ' ')
+    {
+      ++counts.skipped;
+      return;
+    }
+  p += 2;
+  uint64_t second = ParseUnsigned (p, end);   // the fraction does not matter
+  const char *node = Find (p, end, "/NodeList/", simd);
+  if (node == end || second > MAX_SECOND)
+    {
+      ++counts.skipped;
+      return;
+    }
+  node += 10;
+  uint64_t id = ParseUnsigned (node, end);
+  if (id > MAX_NODE_ID)
+    {
+      ++counts.skipped;
+      return;
+    }
+  if (id >= counts.nodes.size ())
+    {
+      counts.nodes.resize (id + 1);
+    }
+  NodeCounts &n = counts.nodes[id];
+
+  uint64_t bytes = 0;
+  const char *payload = Find (node, end, "Payload (size=", simd);
+  if (payload != end)
+    {
+      payload += 14;
+      bytes = ParseUnsigned (payload, end);
+    }
+  if (bytes > 0 && second >= counts.seconds.size ())
+    {
+      counts.seconds.resize (second + 1);
+    }
+  switch (op)
+    {
+    case 't':
+      {
+        ++n.tx;
+        n.txBytes += bytes;
+        if (bytes > 0)
+          {
+            counts.seconds[second].txBytes += bytes;
+          }
+        const char *header = Find (node, end, "WifiMacHeader (DATA ", simd);
+        if (header != end)
+          {
+            ++n.txData;
+            const char *retry = Find (header, end, "Retry=", simd);
+            n.retries += retry + 6 < end && retry[6] == '1';
+          }
+        break;
+      }
+    case 'r':
+      ++n.rx;
+      n.rxBytes += bytes;
+      if (bytes > 0)
+        {
+          counts.seconds[second].rxBytes += bytes;
+        }
+      break;
+    case 'd':
+      ++n.drop;
+      break;
+    }
+}
+
+struct Chunk
+{
+  const char *begin;
+  const char *end;
+  bool simd;
+  TraceCounts counts;
+};
+
+static void *
+CountChunk (void *arg)
+{
+  Chunk *c = static_cast<Chunk *> (arg);
+  for (const char *p = c->begin; p < c->end;)
+    {
+      const char *eol = FindChar (p, c->end, '\n', c->simd);
+      if (eol > p)
+        {
+          CountLine (p, eol, c->simd, c->counts);
+        }
+      p = eol + 1;
+    }
+  return 0;
+}
+
+static TraceCounts
+Analyze (const char *data, size_t length, uint32_t threads, bool simd)
+{
+  std::vector<Chunk> chunks (threads);
+  const char *end = data + length;
+  const char *p = data;
+  for (uint32_t i = 0; i < threads; ++i)
+    {
+      const char *cut = i + 1 == threads ? end : data + length / threads * (i + 1);
+      if (cut < p)
+        {
+          cut = p;
+        }
+      if (cut < end)
+        {
+          cut = FindChar (cut, end, '\n', simd);
+          cut = cut < end ? cut + 1 : end;
+        }
+      chunks[i].begin = p;
+      chunks[i].end = cut;
+      chunks[i].simd = simd;
+      p = cut;
+    }
+  // a chunk whose thread cannot be started is counted here instead
+  std::vector<pthread_t> ids (threads);
+  std::vector<bool> started (threads, false);
+  for (uint32_t i = 1; i < threads; ++i)
+    {
+      started[i] = pthread_create (&ids[i], 0, &CountChunk, &chunks[i]) == 0;
+    }
+  CountChunk (&chunks[0]);
+  TraceCounts total = chunks[0].counts;
+  for (uint32_t i = 1; i < threads; ++i)
+    {
+      if (started[i])
+        {
+          pthread_join (ids[i], 0);
+        }
+      else
+        {
+          CountChunk (&chunks[i]);
+        }
+      total.Add (chunks[i].counts);
+    }
+  return total;
+}
+
+static void
+WritePerNode (std::ostream &os, const TraceCounts &counts)
+{
+  os << "node\ttx\trx\tdrop\ttxData\tretries\tretryRatio\ttxBytes\trxBytes\n";
+  for (uint32_t i = 0; i < counts.nodes.size (); ++i)
+    {
+      const NodeCounts &n = counts.nodes[i];
+      os << i << "\t" << n.tx << "\t" << n.rx << "\t" << n.drop << "\t" << n.txData << "\t" << n.retries << "\t"
+         << (n.txData ? double (n.retries) / n.txData : 0) << "\t" << n.txBytes << "\t" << n.rxBytes << "\n";
+    }
+}
+
+static void
+WritePerSecond (std::ostream &os, const TraceCounts &counts)
+{
+  os << "second\ttxKbps\trxKbps\n";
+  for (uint32_t i = 0; i < counts.seconds.size (); ++i)
+    {
+      os << i << "\t" << counts.seconds[i].txBytes * 8.0 / 1000 << "\t" << counts.seconds[i].rxBytes * 8.0 / 1000
+         << "\n";
+    }
+}
+
+int main (int argc, char **argv)
+{
+  std::string traceName;
+  std::string perNode;
+  std::string perSecond;
+  uint32_t threads = sysconf (_SC_NPROCESSORS_ONLN);
+  bool scalar = false;
+  bool check = false;
+
+  CommandLine cmd;
+  cmd.AddValue ("trace", "ASCII trace of EnableAsciiAll ()", traceName);
+  cmd.AddValue ("perNode", "Write the per node counts to this TSV file (default: stdout)", perNode);
+  cmd.AddValue ("perSecond", "Write the per second throughput to this TSV file", perSecond);
+  cmd.AddValue ("threads", "Threads scanning the trace, Default: all cores", threads);
+  cmd.AddValue ("scalar", "Scan byte by byte instead of with SSE2", scalar);
+  cmd.AddValue ("check", "Compare against a scalar single thread scan", check);
+  cmd.Parse (argc, argv);
+
+  int fd = open (traceName.c_str (), O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0)
+    {
+      std::cerr << "Cannot read " << traceName << "\n";
+      return 1;
+    }
+  size_t length = st.st_size;
+  const char *data = "";
+  if (length > 0)
+    {
+      void *map = mmap (0, length, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map == MAP_FAILED)
+        {
+          std::perror ("mmap");
+          return 1;
+        }
+      madvise (map, length, MADV_SEQUENTIAL);
+      data = static_cast<const char *> (map);
+    }
+  threads = std::max (threads, 1u);
+
+  double start = WallClock ();
+  TraceCounts counts = Analyze (data, length, threads, !scalar);
+  double seconds = WallClock () - start;
+  std::cerr << counts.lines << " lines (" << counts.skipped << " skipped), " << length / 1e6 << " MB in " << seconds
+            << " s on " << threads << " threads: " << (seconds > 0 ? length / seconds / 1e9 : 0) << " GB/s\n";
+
+  if (check)
+    {
+      start = WallClock ();
+      TraceCounts reference = Analyze (data, length, 1, false);
+      seconds = WallClock () - start;
+      std::cerr << "Scalar single thread scan in " << seconds << " s: "
+                << (seconds > 0 ? length / seconds / 1e9 : 0) << " GB/s, match: "
+                << (reference == counts ? "yes" : "NO") << "\n";
+      if (!(reference == counts))
+        {
+          return 1;
+        }
+    }
+
+  uint64_t tx = 0, rx = 0, drop = 0, txData = 0, retries = 0;
+  for (uint32_t i = 0; i < counts.nodes.size (); ++i)
+    {
+      tx += counts.nodes[i].tx;
+      rx += counts.nodes[i].rx;
+      drop += counts.nodes[i].drop;
+      txData += counts.nodes[i].txData;
+      retries += counts.nodes[i].retries;
+    }
+  std::cerr << counts.nodes.size () << " nodes: " << tx << " tx, " << rx << " rx, " << drop << " drops, " << retries
+            << " of " << txData << " DATA transmissions were retries\n";
+
+  if (perNode.empty ())
+    {
+      WritePerNode (std::cout, counts);
+    }
+  else
+    {
+      std::ofstream out (perNode.c_str ());
+      WritePerNode (out, counts);
+    }
+  if (!perSecond.empty ())
+    {
+      std::ofstream out (perSecond.c_str ());
+      WritePerSecond (out, counts);
+    }
+  return 0;
+}
@@ -0,0 +1,300 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+#ifndef TRAFFIC_REPLAY_H
+#define TRAFFIC_REPLAY_H
+
+#include <cstring>
+#include <iostream>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "ns3/core-module.h"
+#include "ns3/network-module.h"
+#include "ns3/internet-module.h"
+#include "run-results.h"
+
+namespace ns3 {
+
+/*
+ * Binary traffic trace: a 16 byte header (magic "TRP1", uint32 record
+ * size, uint64 record count) followed by fixed size records sorted by
+ * time, in host byte order.  traffic-trace.cc writes these files from
+ * text exports of field captures.
+ */
+struct TrafficRecord
+{
+  uint64_t timeNs;   // send time relative to the start of the trace
+  uint32_t src;      // node index of the sender
+  uint32_t dst;      // node index of the receiver
+  uint32_t size;     // UDP payload bytes
+  uint32_t flow;     // flow id of the capture, 0 if unknown
+};
+
+struct TrafficTraceHeader
+{
+  char magic[4];
+  uint32_t recordSize;
+  uint64_t count;
+};
+
+// Read-only mapping of a trace file; pages are read in as records are used
+class TrafficTraceFile
+{
+public:
+  TrafficTraceFile ()
+    : m_fd (-1),
+      m_map (0),
+      m_length (0),
+      m_records (0),
+      m_count (0),
+      m_released (0)
+  {
+  }
+
+  ~TrafficTraceFile ()
+  {
+    Close ();
+  }
+
+  bool Open (std::string fileName)
+  {
+    Close ();
+    m_fd = open (fileName.c_str (), O_RDONLY);
+    struct stat st;
+    if (m_fd < 0 || fstat (m_fd, &st) != 0 || (size_t) st.st_size < sizeof (TrafficTraceHeader))
+      {
+        Close ();
+        return false;
+      }
+    m_length = st.st_size;
+    void *map = mmap (0, m_length, PROT_READ, MAP_SHARED, m_fd, 0);
+    if (map == MAP_FAILED)
+      {
+        Close ();
+        return false;
+      }
+    m_map = static_cast<const char *> (map);
+    TrafficTraceHeader header;
+    std::memcpy (&header, m_map, sizeof (header));
+    // count is checked by division: a corrupt one must not overflow the product
+    if (std::memcmp (header.magic, "TRP1", 4) != 0 || header.recordSize != sizeof (TrafficRecord)
+        || header.count > (m_length - sizeof (header)) / sizeof (TrafficRecord))
+      {
+        Close ();
+        return false;
+      }
+    m_records = reinterpret_cast<const TrafficRecord *> (m_map + sizeof (header));
+    m_count = header.count;
+    madvise (const_cast<char *> (m_map), m_length, MADV_SEQUENTIAL);
+    return true;
+  }
+
+  void Close ()
+  {
+    if (m_map != 0)
+      {
+        munmap (const_cast<char *> (m_map), m_length);
+      }
+    if (m_fd >= 0)
+      {
+        close (m_fd);
+      }
+    m_fd = -1;
+    m_map = 0;
+    m_records = 0;
+    m_count = 0;
+    m_released = 0;
+  }
+
+  uint64_t GetN () const
+  {
+    return m_count;
+  }
+
+  const TrafficRecord &Get (uint64_t i) const
+  {
+    return m_records[i];
+  }
+
+  // Drop the pages of records [0, end) from the page cache mapping, so a
+  // long replay keeps only the records ahead of it resident
+  void Release (uint64_t end)
+  {
+    size_t page = sysconf (_SC_PAGESIZE);
+    size_t upTo = (sizeof (TrafficTraceHeader) + end * sizeof (TrafficRecord)) / page * page;
+    if (upTo > m_released)
+      {
+        madvise (const_cast<char *> (m_map) + m_released, upTo - m_released, MADV_DONTNEED);
+        m_released = upTo;
+      }
+  }
+
+private:
+  TrafficTraceFile (const TrafficTraceFile &);
+  TrafficTraceFile &operator= (const TrafficTraceFile &);
+
+  int m_fd;
+  const char *m_map;
+  size_t m_length;
+  const TrafficRecord *m_records;
+  uint64_t m_count;
+  size_t m_released;   // bytes at the start of the mapping already dropped
+};
+
+/*
+ * Trace-driven traffic for the routing scenarios, in place of the OnOff
+ * flows: --trafficTrace names a TRP1 file whose records are sent as UDP
+ * packets from node src to port 9 of node dst at dataStartTime + time.
+ * Records are read through the mapping and sent in batches: one event
+ * sends every record due within --replayLookahead seconds of its own time
+ * and schedules the next batch at the time of the first record left, so
+ * the event queue holds one replay event however many packets the trace
+ * has.  A packet leaves at most the lookahead early; 0 batches only
+ * records with the same time.  Records naming a node outside the scenario
+ * or sent to themselves, and records the socket refuses to send, are
+ * skipped.  Each sender gets one UDP socket,
+ * created on its first record.
+ */
+class TrafficReplay
+{
+public:
+  TrafficReplay ()
+    : m_lookahead (0.001),
+      m_port (9),
+      m_next (0),
+      m_sent (0),
+      m_skipped (0),
+      m_bytes (0),
+      m_batches (0)
+  {
+  }
+
+  void AddCommandLine (CommandLine &cmd)
+  {
+    cmd.AddValue ("trafficTrace", "Replay this binary traffic trace (see traffic-trace.cc) instead of the OnOff flows", m_fileName);
+    cmd.AddValue ("replayLookahead", "Seconds of trace sent by one replay event, Default:0.001", m_lookahead);
+  }
+
+  bool IsEnabled () const
+  {
+    return !m_fileName.empty ();
+  }
+
+  // Call from Configure (); true if no trace was asked for
+  bool Open ()
+  {
+    return !IsEnabled () || m_trace.Open (m_fileName);
+  }
+
+  void Install (NodeContainer nodes, Ipv4InterfaceContainer interfaces, Time start)
+  {
+    m_nodes = nodes;
+    m_interfaces = interfaces;
+    m_sockets.assign (nodes.GetN (), Ptr<Socket> ());
+    m_start = start;
+    m_next = 0;
+    if (m_trace.GetN () > 0)
+      {
+        Simulator::Schedule (RecordTime (0), &TrafficReplay::SendBatch, this);
+      }
+  }
+
+  void Report (std::ostream &os, RunResults &results)
+  {
+    if (!IsEnabled ())
+      {
+        return;
+      }
+    os << "Traffic replay: " << m_sent << " of " << m_trace.GetN () << " records sent (" << m_skipped
+       << " skipped) in " << m_batches << " batches\n";
+    results.Add ("replayRecords", m_trace.GetN ());
+    results.Add ("replaySent", m_sent);
+    results.Add ("replaySkipped", m_skipped);
+    results.Add ("replayBytes", m_bytes);
+    results.Add ("replayBatches", m_batches);
+  }
+
+private:
+  Time RecordTime (uint64_t i) const
+  {
+    return m_start + NanoSeconds (m_trace.Get (i).timeNs);
+  }
+
+  void SendBatch ()
+  {
+    Time horizon = Simulator::Now () + Seconds (m_lookahead);
+    for (; m_next < m_trace.GetN () && RecordTime (m_next) <= horizon; ++m_next)
+      {
+        Send (m_trace.Get (m_next));
+      }
+    ++m_batches;
+    if ((m_batches & 1023) == 0)
+      {
+        m_trace.Release (m_next);
+      }
+    if (m_next < m_trace.GetN ())
+      {
+        Simulator::Schedule (RecordTime (m_next) - Simulator::Now (), &TrafficReplay::SendBatch, this);
+      }
+  }
+
+  void Send (const TrafficRecord &r)
+  {
+    if (r.src >= m_nodes.GetN () || r.dst >= m_nodes.GetN () || r.src == r.dst)
+      {
+        ++m_skipped;
+        return;
+      }
+    Ptr<Socket> &socket = m_sockets[r.src];
+    if (socket == 0)
+      {
+        socket = Socket::CreateSocket (m_nodes.Get (r.src), UdpSocketFactory::GetTypeId ());
+        socket->Bind ();
+      }
+    // size only: the payload stays a virtual zero area until serialized;
+    // SendTo () fails e.g. for sizes above the UDP maximum
+    if (socket->SendTo (Create<Packet> (r.size), 0, InetSocketAddress (m_interfaces.GetAddress (r.dst), m_port)) < 0)
+      {
+        ++m_skipped;
+        return;
+      }
+    ++m_sent;
+    m_bytes += r.size;
+  }
+
+  std::string m_fileName;
+  double m_lookahead;      // seconds
+  uint16_t m_port;
+  TrafficTraceFile m_trace;
+  NodeContainer m_nodes;
+  Ipv4InterfaceContainer m_interfaces;
+  std::vector<Ptr<Socket> > m_sockets;   // per sender node, created on first use
+  Time m_start;
+  uint64_t m_next;         // first record not sent yet
+  uint64_t m_sent;
+  uint64_t m_skipped;
+  uint64_t m_bytes;
+  uint64_t m_batches;
+};
+
+} // namespace ns3
+
+#endif /* TRAFFIC_REPLAY_H */
@@ -0,0 +1,316 @@
+/* -*- Mode:C++; c-file-style:"gnu"; indent-tabs-mode:nil; -*- */
+/*
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 as
+ * published by the Free Software Foundation;
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ */
+
+/*
+ * Writes and inspects the binary traffic traces replayed by the routing
+ * scenarios with --trafficTrace (see traffic-replay.h).
+ *
+ * ./waf --run "traffic-trace --text=exercise.txt --out=exercise.trp"
+ *     converts a text export, one packet per line: time (s), source node,
+ *     destination node, payload bytes and optionally a flow id; '#'
+ *     starts a comment.  The records are streamed to the output and, if
+ *     the input was not in time order, sorted in place through a mapping
+ *     of the output file.
+ * ./waf --run "traffic-trace --synthetic=5000000 --nodes=30 --duration=900 --out=load.trp"
+ *     Poisson traffic between random node pairs, for load tests
+ * ./waf --run "traffic-trace --info=exercise.trp"
+ *     record count, time span, senders, bytes and the scan rate of the mapping
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "ns3/core-module.h"
+#include "traffic-replay.h"
+#include "wall-clock.h"
+
+using namespace ns3;
+
+static bool
+EarlierRecord (const TrafficRecord &a, const TrafficRecord &b)
+{
+  return a.timeNs < b.timeNs;
+}
+
+/*
+ * Streams records to a TRP1 file; Close () writes the count and sorts if
+ * needed.  A failed write is remembered and makes Close () fail.
+ */
+class TrafficTraceWriter
+{
+public:
+  TrafficTraceWriter ()
+    : m_file (0),
+      m_count (0),
+      m_last (0),
+      m_sorted (true),
+      m_failed (false),
+      m_created (false)
+  {
+  }
+
+  bool Open (std::string fileName)
+  {
+    m_fileName = fileName;
+    m_file = std::fopen (fileName.c_str (), "wb");
+    struct stat st;
+    // only a regular file is ours to delete; --out may name a device
+    m_created = m_file != 0 && fstat (fileno (m_file), &st) == 0 && S_ISREG (st.st_mode);
+    TrafficTraceHeader header;
+    std::memcpy (header.magic, "TRP1", 4);
+    header.recordSize = sizeof (TrafficRecord);
+    header.count = 0;
+    return m_file != 0 && std::fwrite (&header, sizeof (header), 1, m_file) == 1;
+  }
+
+  void Add (const TrafficRecord &r)
+  {
+    m_sorted = m_sorted && r.timeNs >= m_last;
+    m_last = r.timeNs;
+    m_failed = m_failed || std::fwrite (&r, sizeof (r), 1, m_file) != 1;
+    ++m_count;
+  }
+
+  bool Close ()
+  {
+    TrafficTraceHeader header;
+    std::memcpy (header.magic, "TRP1", 4);
+    header.recordSize = sizeof (TrafficRecord);
+    header.count = m_count;
+    bool ok = !m_failed && std::fseek (m_file, 0, SEEK_SET) == 0
+      && std::fwrite (&header, sizeof (header), 1, m_file) == 1;
+    ok = std::fclose (m_file) == 0 && ok;
+    m_file = 0;
+    if (ok && !m_sorted)
+      {
+        ok = Sort ();
+      }
+    return ok;
+  }
+
+  // Closes and deletes the regular file Open () wrote, after a failed export
+  void Discard ()
+  {
+    if (m_file != 0)
+      {
+        std::fclose (m_file);
+        m_file = 0;
+      }
+    if (m_created)
+      {
+        std::remove (m_fileName.c_str ());
+        m_created = false;
+      }
+  }
+
+  uint64_t GetN () const
+  {
+    return m_count;
+  }
+
+  bool WasSorted () const
+  {
+    return m_sorted;
+  }
+
+private:
+  // stable, so packets with the same time keep the order of the export
+  bool Sort ()
+  {
+    int fd = open (m_fileName.c_str (), O_RDWR);
+    size_t length = sizeof (TrafficTraceHeader) + m_count * sizeof (TrafficRecord);
+    void *map = fd < 0 ? MAP_FAILED : mmap (0, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED)
+      {
+        if (fd >= 0)
+          {
+            close (fd);
+          }
+        return false;
+      }
+    TrafficRecord *records = reinterpret_cast<TrafficRecord *> (static_cast<char *> (map) + sizeof (TrafficTraceHeader));
+    std::stable_sort (records, records + m_count, EarlierRecord);
+    munmap (map, length);
+    close (fd);
+    return true;
+  }
+
+  std::string m_fileName;
+  FILE *m_file;
+  uint64_t m_count;
+  uint64_t m_last;
+  bool m_sorted;
+  bool m_failed;
+  bool m_created;
+};
+
+static bool
+ConvertText (std::string textName, TrafficTraceWriter &writer)
+{
+  std::ifstream in (textName.c_str ());
+  if (!in)
+    {
+      std::cerr << "Cannot read " << textName << "\n";
+      return false;
+    }
+  std::string line;
+  uint64_t lineNo = 0;
+  while (std::getline (in, line))
+    {
+      ++lineNo;
+      std::string::size_type hash = line.find ('#');
+      if (hash != std::string::npos)
+        {
+          line.erase (hash);
+        }
+      std::istringstream fields (line);
+      double time;
+      TrafficRecord r;
+      if (!(fields >> time))
+        {
+          continue;   // blank line
+        }
+      if (!(fields >> r.src >> r.dst >> r.size) || time < 0)
+        {
+          std::cerr << textName << ":" << lineNo << ": expected time src dst size [flow]\n";
+          return false;
+        }
+      r.flow = 0;
+      fields >> r.flow;
+      r.timeNs = (uint64_t) (time * 1e9 + 0.5);
+      writer.Add (r);
+    }
+  return true;
+}
+
+static void
+Synthesize (uint64_t count, uint32_t nodes, double duration, uint32_t size, TrafficTraceWriter &writer)
+{
+  Ptr<UniformRandomVariable> u = CreateObject<UniformRandomVariable> ();
+  double mean = duration / count;   // exponential gaps of this mean
+  double time = 0;
+  for (uint64_t i = 0; i < count; ++i)
+    {
+      time += -mean * std::log (1 - u->GetValue ());
+      TrafficRecord r;
+      r.timeNs = (uint64_t) (time * 1e9);
+      r.src = u->GetInteger (0, nodes - 1);
+      r.dst = (r.src + u->GetInteger (1, nodes - 1)) % nodes;
+      r.size = size;
+      r.flow = r.src * nodes + r.dst;
+      writer.Add (r);
+    }
+}
+
+static bool
+Info (std::string fileName)
+{
+  TrafficTraceFile trace;
+  if (!trace.Open (fileName))
+    {
+      std::cerr << "Not a traffic trace: " << fileName << "\n";
+      return false;
+    }
+  double start = WallClock ();
+  std::vector<bool> senders;
+  uint64_t bytes = 0;
+  for (uint64_t i = 0; i < trace.GetN (); ++i)
+    {
+      const TrafficRecord &r = trace.Get (i);
+      if (r.src >= senders.size ())
+        {
+          senders.resize (r.src + 1);
+        }
+      senders[r.src] = true;
+      bytes += r.size;
+    }
+  double scan = WallClock () - start;
+  uint32_t nSenders = std::count (senders.begin (), senders.end (), true);
+  std::cout << trace.GetN () << " records";
+  if (trace.GetN () > 0)
+    {
+      std::cout << " from " << trace.Get (0).timeNs * 1e-9 << " s to " << trace.Get (trace.GetN () - 1).timeNs * 1e-9
+                << " s";
+    }
+  std::cout << ", " << nSenders << " senders, " << bytes << " payload bytes\n"
+            << "Scanned in " << scan << " s (" << (scan > 0 ? trace.GetN () / scan / 1e6 : 0) << " M records/s)\n";
+  return true;
+}
+
+int main (int argc, char **argv)
+{
+  std::string text;
+  std::string out;
+  std::string info;
+  uint64_t synthetic = 0;
+  uint32_t nodes = 30;
+  double duration = 900;
+  uint32_t size = 64;
+
+  CommandLine cmd;
+  cmd.AddValue ("text", "Text export to convert: time src dst size [flow] per line", text);
+  cmd.AddValue ("synthetic", "Write this many Poisson distributed records instead", synthetic);
+  cmd.AddValue ("nodes", "Synthetic: number of nodes, Default:30", nodes);
+  cmd.AddValue ("duration", "Synthetic: seconds of traffic, Default:900", duration);
+  cmd.AddValue ("size", "Synthetic: payload bytes, Default:64", size);
+  cmd.AddValue ("out", "Binary trace to write", out);
+  cmd.AddValue ("info", "Summarise this binary trace", info);
+  cmd.Parse (argc, argv);
+
+  if (!info.empty ())
+    {
+      return Info (info) ? 0 : 1;
+    }
+  if (out.empty () || text.empty () == (synthetic == 0) || nodes < 2)
+    {
+      std::cerr << "Give --out and one of --text or --synthetic (with --nodes of at least 2)\n";
+      return 1;
+    }
+  TrafficTraceWriter writer;
+  if (!writer.Open (out))
+    {
+      std::cerr << "Cannot write " << out << "\n";
+      writer.Discard ();
+      return 1;
+    }
+  double start = WallClock ();
+  if (!text.empty () && !ConvertText (text, writer))
+    {
+      writer.Discard ();
+      return 1;
+    }
+  if (synthetic > 0)
+    {
+      Synthesize (synthetic, nodes, duration, size, writer);
+    }
+  bool sorted = writer.WasSorted ();
+  if (!writer.Close ())
+    {
+      std::cerr << "Cannot write " << out << "\n";
+      writer.Discard ();
+      return 1;
+    }
+  std::cout << writer.GetN () << " records written to " << out << (sorted ? "" : " (sorted by time)") << " in "
+            << WallClock () - start << " s\n";
+  return 0;
+}